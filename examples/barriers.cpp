@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB.
+ * All Rights Reserved.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <uvre/uvre.hpp>
+#include <GLFW/glfw3.h>
+#include <exception>
+#include <iostream>
+
+// Compute shader source, writes the triangle
+static const char *comp_source = R"(
+layout(local_size_x = 3) in;
+layout(std430, binding = 0) buffer Positions {
+    vec2 positions[];
+};
+void main()
+{
+    const vec2 corners[3] = vec2[3](vec2(-0.8, -0.8), vec2(0.0, 0.8), vec2(0.8, -0.8));
+    positions[gl_LocalInvocationIndex] = corners[gl_LocalInvocationIndex];
+})";
+
+// Vertex shader source, only reads the triangle
+static const char *vert_source = R"(
+layout(std430, binding = 1) readonly buffer Positions {
+    vec2 positions[];
+};
+void main()
+{
+    gl_Position = vec4(positions[gl_VertexID], 0.0, 1.0);
+})";
+
+// Fragment shader source
+static const char *frag_source = R"(
+layout(location = 0) out vec4 target;
+void main()
+{
+    target = vec4(1.0, 1.0, 1.0, 1.0);
+})";
+
+int main()
+{
+    if(!glfwInit())
+        std::terminate();
+
+    uvre::ImplInfo impl_info;
+    uvre::pollImplInfo(impl_info);
+
+    // We don't need to see anything
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    if(impl_info.family == uvre::ImplFamily::OPENGL) {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, impl_info.gl.core_profile ? GLFW_OPENGL_CORE_PROFILE : GLFW_OPENGL_COMPAT_PROFILE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, impl_info.gl.version_major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, impl_info.gl.version_minor);
+
+#if defined(__APPLE__)
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+    }
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "UVRE - Barriers", nullptr, nullptr);
+    if(!window)
+        std::terminate();
+
+    uvre::DeviceCreateInfo device_info = {};
+    if(impl_info.family == uvre::ImplFamily::OPENGL) {
+        device_info.gl.user_data = window;
+        device_info.gl.getProcAddr = [](void *, const char *procname) { return reinterpret_cast<void *>(glfwGetProcAddress(procname)); };
+        device_info.gl.makeContextCurrent = [](void *arg) { glfwMakeContextCurrent(reinterpret_cast<GLFWwindow *>(arg)); };
+        device_info.gl.setSwapInterval = [](void *, int interval) { glfwSwapInterval(interval); };
+        device_info.gl.swapBuffers = [](void *arg) { glfwSwapBuffers(reinterpret_cast<GLFWwindow *>(arg)); };
+    }
+
+    uvre::IRenderDevice *device = uvre::createDevice(device_info);
+    if(!device)
+        std::terminate();
+
+    int result = 0;
+
+    if(!device->getInfo().supports_compute) {
+        std::cout << "compute is not supported, skipping" << std::endl;
+    }
+    else {
+        uvre::ICommandList *commands = device->createCommandList();
+
+        uvre::ShaderCreateInfo comp_info = {};
+        comp_info.stage = uvre::ShaderStage::COMPUTE;
+        comp_info.format = uvre::ShaderFormat::SOURCE_GLSL;
+        comp_info.code = comp_source;
+
+        uvre::ShaderCreateInfo vert_info = {};
+        vert_info.stage = uvre::ShaderStage::VERTEX;
+        vert_info.format = uvre::ShaderFormat::SOURCE_GLSL;
+        vert_info.code = vert_source;
+
+        uvre::ShaderCreateInfo frag_info = {};
+        frag_info.stage = uvre::ShaderStage::FRAGMENT;
+        frag_info.format = uvre::ShaderFormat::SOURCE_GLSL;
+        frag_info.code = frag_source;
+
+        uvre::Shader comp_shaders[1] = { device->createShader(comp_info) };
+        uvre::Shader draw_shaders[2] = { device->createShader(vert_info), device->createShader(frag_info) };
+
+        uvre::PipelineCreateInfo comp_pipeline_info = {};
+        comp_pipeline_info.num_shaders = 1;
+        comp_pipeline_info.shaders = comp_shaders;
+
+        uvre::PipelineCreateInfo draw_pipeline_info = {};
+        draw_pipeline_info.primitive_mode = uvre::PrimitiveMode::TRIANGLES;
+        draw_pipeline_info.fill_mode = uvre::FillMode::FILLED;
+        draw_pipeline_info.num_shaders = 2;
+        draw_pipeline_info.shaders = draw_shaders;
+
+        uvre::Pipeline comp_pipeline = device->createPipeline(comp_pipeline_info);
+        uvre::Pipeline draw_pipeline = device->createPipeline(draw_pipeline_info);
+
+        uvre::BufferCreateInfo buffer_info = {};
+        buffer_info.type = uvre::BufferType::DATA_BUFFER;
+        buffer_info.size = sizeof(float) * 2 * 3;
+        uvre::Buffer positions = device->createBuffer(buffer_info);
+
+        // Write once, read twice: the first draw needs
+        // a barrier, the second one sees the same data.
+        device->prepare();
+        device->startRecording(commands);
+        commands->bindPipeline(comp_pipeline);
+        commands->bindStorageBuffer(positions, 0, true);
+        commands->dispatch(1, 1, 1);
+        commands->bindPipeline(draw_pipeline);
+        commands->bindStorageBuffer(positions, 1);
+        commands->draw(3, 1, 0, 0);
+        commands->draw(3, 1, 0, 0);
+
+        const size_t num_barriers = device->getNumBarriers();
+        device->submit(commands);
+
+        const size_t issued = device->getNumBarriers() - num_barriers;
+        std::cout << "write, read, read: " << issued << " barrier(s), expected 1" << std::endl;
+        if(issued != 1)
+            result = 1;
+
+        device->destroyCommandList(commands);
+    }
+
+    uvre::destroyDevice(device);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return result;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB.
+ * All Rights Reserved.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <uvre/uvre.hpp>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Vertex shader source
+static const char *vert_source = R"(
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texcoord;
+out VS_OUTPUT {
+    vec2 texcoord;
+} vert;
+void main()
+{
+    vert.texcoord = texcoord;
+    gl_Position = vec4(position, 0.0, 1.0);
+})";
+
+// Fragment shader source
+static const char *frag_source = R"(
+layout(location = 0) out vec4 target;
+in VS_OUTPUT {
+    vec2 texcoord;
+} vert;
+void main()
+{
+    target = vec4(vert.texcoord, 1.0, 1.0);
+})";
+
+// Cache statistics
+struct cache_stats final {
+    int hits;
+    int misses;
+};
+
+// Every binary is stored in a separate file
+static std::string getCachePath(uint64_t key)
+{
+    std::stringstream ss;
+    ss << "shader_cache_" << std::hex << key << ".bin";
+    return ss.str();
+}
+
+static size_t loadProgram(void *user_data, uint64_t key, void *data, size_t size)
+{
+    cache_stats *stats = reinterpret_cast<cache_stats *>(user_data);
+    std::ifstream file(getCachePath(key), std::ios::binary | std::ios::ate);
+    if(!file) {
+        stats->misses++;
+        return 0;
+    }
+
+    // The first call only asks for the size
+    const size_t file_size = static_cast<size_t>(file.tellg());
+    if(data) {
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(std::min(size, file_size)));
+        stats->hits++;
+    }
+
+    return file_size;
+}
+
+static void storeProgram(void *, uint64_t key, const void *data, size_t size)
+{
+    std::ofstream file(getCachePath(key), std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+}
+
+int main()
+{
+    if(!glfwInit())
+        std::terminate();
+
+    uvre::ImplInfo impl_info;
+    uvre::pollImplInfo(impl_info);
+
+    // We don't need to see anything
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    if(impl_info.family == uvre::ImplFamily::OPENGL) {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, impl_info.gl.core_profile ? GLFW_OPENGL_CORE_PROFILE : GLFW_OPENGL_COMPAT_PROFILE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, impl_info.gl.version_major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, impl_info.gl.version_minor);
+
+#if defined(__APPLE__)
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+    }
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "UVRE - Shader cache", nullptr, nullptr);
+    if(!window)
+        std::terminate();
+
+    cache_stats stats = {};
+
+    uvre::DeviceCreateInfo device_info = {};
+    if(impl_info.family == uvre::ImplFamily::OPENGL) {
+        device_info.gl.user_data = window;
+        device_info.gl.getProcAddr = [](void *, const char *procname) { return reinterpret_cast<void *>(glfwGetProcAddress(procname)); };
+        device_info.gl.makeContextCurrent = [](void *arg) { glfwMakeContextCurrent(reinterpret_cast<GLFWwindow *>(arg)); };
+        device_info.gl.setSwapInterval = [](void *, int interval) { glfwSwapInterval(interval); };
+        device_info.gl.swapBuffers = [](void *arg) { glfwSwapBuffers(reinterpret_cast<GLFWwindow *>(arg)); };
+    }
+
+    // Program binaries go to the working directory
+    device_info.program_cache.user_data = &stats;
+    device_info.program_cache.load = &loadProgram;
+    device_info.program_cache.store = &storeProgram;
+
+    uvre::IRenderDevice *device = uvre::createDevice(device_info);
+    if(!device)
+        std::terminate();
+
+    {
+        uvre::ShaderCreateInfo vert_info = {};
+        vert_info.stage = uvre::ShaderStage::VERTEX;
+        vert_info.format = uvre::ShaderFormat::SOURCE_GLSL;
+        vert_info.code = vert_source;
+
+        uvre::ShaderCreateInfo frag_info = {};
+        frag_info.stage = uvre::ShaderStage::FRAGMENT;
+        frag_info.format = uvre::ShaderFormat::SOURCE_GLSL;
+        frag_info.code = frag_source;
+
+        // Run this twice: the first run compiles
+        // everything, the second one should only
+        // load the binaries stored by the first one.
+        const auto start = std::chrono::steady_clock::now();
+        uvre::Shader vert = device->createShader(vert_info);
+        uvre::Shader frag = device->createShader(frag_info);
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        std::cout << (stats.hits ? "warm" : "cold") << " cache: " << usec << " us";
+        std::cout << " (" << stats.hits << " hits, " << stats.misses << " misses)" << std::endl;
+    }
+
+    uvre::destroyDevice(device);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
@@ -34,7 +34,7 @@ static inline uint32_t getTargetMask(uvre::RenderTargetMask mask)
 }
 
 uvre::CommandListImpl::CommandListImpl()
-    : commands(), num_commands(0)
+    : commands(), num_commands(0), pass_target(0), pass_discard(0), names(), groups()
 {
 }
 
@@ -98,6 +98,79 @@ void uvre::CommandListImpl::clear(uvre::RenderTargetMask mask)
     pushCommand(commands, cmd, num_commands++);
 }
 
+void uvre::CommandListImpl::beginRenderPass(const uvre::RenderPassInfo &info)
+{
+    uint32_t invalidate = 0;
+    uint32_t discard = 0;
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        const uvre::RenderPassColorAttachment &attachment = info.color_attachments[i];
+        if(attachment.id >= uvre::MAX_PASS_COLOR_ATTACHMENTS)
+            continue;
+        if(attachment.load == uvre::LoadAction::DONT_CARE)
+            invalidate |= (1 << attachment.id);
+        if(attachment.store == uvre::StoreAction::DISCARD)
+            discard |= (1 << attachment.id);
+    }
+
+    if(info.depth.load == uvre::LoadAction::DONT_CARE)
+        invalidate |= uvre::PASS_DEPTH_ATTACHMENT;
+    if(info.depth.store == uvre::StoreAction::DISCARD)
+        discard |= uvre::PASS_DEPTH_ATTACHMENT;
+    if(info.stencil.load == uvre::LoadAction::DONT_CARE)
+        invalidate |= uvre::PASS_STENCIL_ATTACHMENT;
+    if(info.stencil.store == uvre::StoreAction::DISCARD)
+        discard |= uvre::PASS_STENCIL_ATTACHMENT;
+
+    pass_target = info.target ? info.target->fbobj : 0;
+    pass_discard = discard;
+
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::BEGIN_RENDER_PASS;
+    cmd.pass.target = pass_target;
+    cmd.pass.attachments = invalidate;
+    pushCommand(commands, cmd, num_commands++);
+
+    cmd = {};
+    cmd.type = uvre::CommandType::CLEAR_ATTACHMENT;
+    cmd.attachment_clear.target = pass_target;
+
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        const uvre::RenderPassColorAttachment &attachment = info.color_attachments[i];
+        if(attachment.id < uvre::MAX_PASS_COLOR_ATTACHMENTS && attachment.load == uvre::LoadAction::CLEAR) {
+            cmd.attachment_clear.buffer = GL_COLOR;
+            cmd.attachment_clear.drawbuffer = static_cast<int32_t>(attachment.id);
+            std::copy(attachment.clear_color, attachment.clear_color + 4, cmd.attachment_clear.color);
+            pushCommand(commands, cmd, num_commands++);
+        }
+    }
+
+    if(info.depth.load == uvre::LoadAction::CLEAR) {
+        cmd.attachment_clear.buffer = GL_DEPTH;
+        cmd.attachment_clear.drawbuffer = 0;
+        cmd.attachment_clear.depth = info.depth.clear_value;
+        pushCommand(commands, cmd, num_commands++);
+    }
+
+    if(info.stencil.load == uvre::LoadAction::CLEAR) {
+        cmd.attachment_clear.buffer = GL_STENCIL;
+        cmd.attachment_clear.drawbuffer = 0;
+        cmd.attachment_clear.stencil = info.stencil.clear_value;
+        pushCommand(commands, cmd, num_commands++);
+    }
+}
+
+void uvre::CommandListImpl::endRenderPass()
+{
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::END_RENDER_PASS;
+    cmd.pass.target = pass_target;
+    cmd.pass.attachments = pass_discard;
+    pushCommand(commands, cmd, num_commands++);
+
+    pass_target = 0;
+    pass_discard = 0;
+}
+
 void uvre::CommandListImpl::bindPipeline(uvre::Pipeline pipeline)
 {
     uvre::Command cmd = {};
@@ -106,7 +179,7 @@ void uvre::CommandListImpl::bindPipeline(uvre::Pipeline pipeline)
     pushCommand(commands, cmd, num_commands++);
 }
 
-void uvre::CommandListImpl::bindStorageBuffer(uvre::Buffer buffer, uint32_t index)
+void uvre::CommandListImpl::bindStorageBuffer(uvre::Buffer buffer, uint32_t index, bool)
 {
     uvre::Command cmd = {};
     cmd.type = uvre::CommandType::BIND_STORAGE_BUFFER;
@@ -169,6 +242,24 @@ void uvre::CommandListImpl::bindRenderTarget(uvre::RenderTarget target)
     pushCommand(commands, cmd, num_commands++);
 }
 
+void uvre::CommandListImpl::bindImage(uvre::Texture, uint32_t, int, int, uvre::ImageAccess, uvre::PixelFormat)
+{
+    // Image load/store is not core in GL 3.3
+}
+
+void uvre::CommandListImpl::bindGroup(uvre::BindGroup group, uint32_t set)
+{
+    if(!group)
+        return;
+
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::BIND_GROUP;
+    cmd.bind_index = set;
+    cmd.group = group.get();
+    groups.push_back(group);
+    pushCommand(commands, cmd, num_commands++);
+}
+
 void uvre::CommandListImpl::writeBuffer(uvre::Buffer buffer, size_t offset, size_t size, const void *data)
 {
     uvre::Command cmd = {};
@@ -181,6 +272,43 @@ void uvre::CommandListImpl::writeBuffer(uvre::Buffer buffer, size_t offset, size
     pushCommand(commands, cmd, num_commands++);
 }
 
+void uvre::CommandListImpl::generateMipmaps(uvre::Texture texture)
+{
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::GENERATE_MIPMAPS;
+    cmd.object = texture->texobj;
+    cmd.tex_target = texture->target;
+    pushCommand(commands, cmd, num_commands++);
+}
+
+void uvre::CommandListImpl::copyTexture(uvre::Texture src, int src_level, int sx, int sy, int sz, uvre::Texture dst, int dst_level, int dx, int dy, int dz, int width, int height, int depth)
+{
+    // Copies are blits here, those can't read compressed
+    // textures and would convert between different formats.
+    if(src->compressed || dst->compressed || src->format != dst->format)
+        return;
+
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::COPY_TEXTURE;
+    cmd.tex_copy.src = src->texobj;
+    cmd.tex_copy.dst = dst->texobj;
+    cmd.tex_copy.src_target = src->target;
+    cmd.tex_copy.dst_target = dst->target;
+    cmd.tex_copy.format = src->format;
+    cmd.tex_copy.src_level = src_level;
+    cmd.tex_copy.dst_level = dst_level;
+    cmd.tex_copy.sx = sx;
+    cmd.tex_copy.sy = sy;
+    cmd.tex_copy.sz = sz;
+    cmd.tex_copy.dx = dx;
+    cmd.tex_copy.dy = dy;
+    cmd.tex_copy.dz = dz;
+    cmd.tex_copy.w = width;
+    cmd.tex_copy.h = height;
+    cmd.tex_copy.d = depth;
+    pushCommand(commands, cmd, num_commands++);
+}
+
 void uvre::CommandListImpl::copyRenderTarget(uvre::RenderTarget src, uvre::RenderTarget dst, int sx0, int sy0, int sx1, int sy1, int dx0, int dy0, int dx1, int dy1, uvre::RenderTargetMask mask, bool filter)
 {
     uvre::Command cmd = {};
@@ -222,3 +350,52 @@ void uvre::CommandListImpl::idraw(size_t indices, size_t instances, size_t base_
     cmd.draw.e.base_instance = static_cast<int32_t>(base_instance);
     pushCommand(commands, cmd, num_commands++);
 }
+
+void uvre::CommandListImpl::dispatch(uint32_t, uint32_t, uint32_t)
+{
+    // Compute shaders are not core in GL 3.3
+}
+
+void uvre::CommandListImpl::dispatchIndirect(uvre::Buffer, size_t)
+{
+    // Compute shaders are not core in GL 3.3
+}
+
+void uvre::CommandListImpl::memoryBarrier(uvre::BarrierMask)
+{
+    // Nothing can write memory behind GL's back
+}
+
+void uvre::CommandListImpl::beginTimer(const char *name)
+{
+    // Commands have to stay trivially copyable,
+    // so they only refer to the name by index.
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::BEGIN_TIMER;
+    cmd.object = static_cast<uint32_t>(names.size());
+    names.push_back(name ? name : "");
+    pushCommand(commands, cmd, num_commands++);
+}
+
+void uvre::CommandListImpl::endTimer()
+{
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::END_TIMER;
+    pushCommand(commands, cmd, num_commands++);
+}
+
+void uvre::CommandListImpl::pushDebugGroup(const char *name)
+{
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::PUSH_DEBUG_GROUP;
+    cmd.object = static_cast<uint32_t>(names.size());
+    names.push_back(name ? name : "");
+    pushCommand(commands, cmd, num_commands++);
+}
+
+void uvre::CommandListImpl::popDebugGroup()
+{
+    uvre::Command cmd = {};
+    cmd.type = uvre::CommandType::POP_DEBUG_GROUP;
+    pushCommand(commands, cmd, num_commands++);
+}
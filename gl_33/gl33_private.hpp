@@ -8,14 +8,47 @@
  */
 #include <uvre/uvre.hpp>
 #include <algorithm>
+#include <chrono>
+#include <deque>
 #include <glad/gl.h>
 #include <limits>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace uvre
 {
+// Statistics cost nothing when they're compiled out
+#if defined(UVRE_FRAME_STATS)
+static constexpr const bool FRAME_STATS_ENABLED = true;
+#else
+static constexpr const bool FRAME_STATS_ENABLED = false;
+#endif
+
+// S3TC is not core and BPTC only became core
+// in 4.2, so GLAD doesn't know about either
+static constexpr const uint32_t COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+static constexpr const uint32_t COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+static constexpr const uint32_t COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+// Frame fences are polled this often (in nanoseconds) while waiting
+static constexpr const uint64_t FRAME_FENCE_TIMEOUT = 1000000000;
+
+// Timestamp queries are created this many at a time
+static constexpr const size_t TIMER_QUERY_BATCH = 32;
+
+// Every stage gets its own precomputed source prologue
+static constexpr const size_t NUM_SHADER_STAGES = 4;
+
+// Unused transient render targets are destroyed after this many frames
+static constexpr const uint64_t TRANSIENT_TARGET_LIFETIME = 8;
+
+// Render pass attachment bits, color attachments use the lower bits
+static constexpr const uint32_t MAX_PASS_COLOR_ATTACHMENTS = 8;
+static constexpr const uint32_t PASS_DEPTH_ATTACHMENT = (1 << 8);
+static constexpr const uint32_t PASS_STENCIL_ATTACHMENT = (1 << 9);
+
 struct VertexArray_S final {
     uint32_t index;
     uint32_t vaobj;
@@ -30,11 +63,15 @@ struct VBOBinding final {
 };
 
 struct Shader_S final {
+    uint64_t id;
+    uint64_t key_hash;
     uint32_t shader;
     ShaderStage stage;
 };
 
 struct Pipeline_S final {
+    uint64_t id;
+    uint64_t key_hash;
     uint32_t bound_ibo; // OPTIMIZE
     uint32_t bound_vao; // OPTIMIZE
     uint32_t program;
@@ -77,22 +114,85 @@ struct Texture_S final {
     int width;
     int height;
     int depth;
+    int levels;
+    bool compressed; // can't be attached to framebuffers
+};
+
+struct UploadRegion final {
+    UploadTicket ticket;
+    GLsync fence;
+    size_t offset;
+    size_t size;
 };
 
 struct Sampler_S final {
+    uint64_t key_hash;
     uint32_t ssobj;
 };
 
+struct BindGroupBinding final {
+    BindingType type;
+    uint32_t index;
+    uint32_t object;
+    uint32_t target;
+    size_t offset;
+    size_t size;
+};
+
+// Entries are kept around so that the resources
+// live at least as long as the group referencing them.
+struct BindGroup_S final {
+    uint64_t id;
+    uint32_t slots;
+    std::vector<BindGroupEntry> entries;
+    std::vector<BindGroupBinding> bindings;
+};
+
+// Content-addressed objects are looked up by a hash of their
+// create info, the full key only settles hash collisions.
+template<typename T>
+struct CacheEntry final {
+    std::string key;
+    std::weak_ptr<T> object;
+};
+
 struct RenderTarget_S final {
     uint32_t fbobj;
 };
 
+// Both timestamps are allocated when a timer begins,
+// the end one is only written if the timer is ended.
+struct TimerRegion final {
+    std::string name;
+    uint32_t queries[2];
+    bool ended;
+};
+
+struct TimerFrame final {
+    std::vector<TimerRegion> regions;
+};
+
+struct TransientTargetEntry final {
+    int width;
+    int height;
+    size_t num_color_attachments;
+    PixelFormat color_formats[MAX_COLOR_ATTACHMENTS];
+    bool use_depth;
+    PixelFormat depth_format;
+    bool in_use;
+    uint64_t last_frame;
+    TransientTarget target;
+};
+
 enum class CommandType {
     SET_SCISSOR,
     SET_VIEWPORT,
     SET_CLEAR_DEPTH,
     SET_CLEAR_COLOR,
     CLEAR,
+    BEGIN_RENDER_PASS,
+    CLEAR_ATTACHMENT,
+    END_RENDER_PASS,
     BIND_PIPELINE,
     BIND_STORAGE_BUFFER,
     BIND_UNIFORM_BUFFER,
@@ -101,10 +201,17 @@ enum class CommandType {
     BIND_SAMPLER,
     BIND_TEXTURE,
     BIND_RENDER_TARGET,
+    BIND_GROUP,
     WRITE_BUFFER,
+    GENERATE_MIPMAPS,
+    COPY_TEXTURE,
     COPY_RENDER_TARGET,
     DRAW,
-    IDRAW
+    IDRAW,
+    BEGIN_TIMER,
+    END_TIMER,
+    PUSH_DEBUG_GROUP,
+    POP_DEBUG_GROUP
 };
 
 union DrawCmd final {
@@ -135,9 +242,22 @@ struct Command final {
         float color[4];
         float depth;
         uint32_t clear_mask;
+        struct {
+            uint32_t target;
+            uint32_t attachments;
+        } pass;
+        struct {
+            uint32_t target;
+            uint32_t buffer;
+            int32_t drawbuffer;
+            float color[4];
+            float depth;
+            int32_t stencil;
+        } attachment_clear;
         Pipeline_S pipeline;
         Buffer_S buffer;
         uint32_t object;
+        const BindGroup_S *group;
         struct {
             uint32_t buffer;
             size_t offset;
@@ -151,6 +271,15 @@ struct Command final {
             uint32_t mask;
             uint32_t filter;
         } rt_copy;
+        struct {
+            uint32_t src, dst;
+            uint32_t src_target, dst_target;
+            uint32_t format;
+            int src_level, dst_level;
+            int sx, sy, sz;
+            int dx, dy, dz;
+            int w, h, d;
+        } tex_copy;
         DrawCmd draw;
     };
 };
@@ -168,24 +297,46 @@ public:
     void setClearColor4f(float r, float g, float b, float a) override;
     void clear(RenderTargetMask mask) override;
 
+    void beginRenderPass(const RenderPassInfo &info) override;
+    void endRenderPass() override;
+
     void bindPipeline(Pipeline pipeline) override;
-    void bindStorageBuffer(Buffer buffer, uint32_t index) override;
+    void bindStorageBuffer(Buffer buffer, uint32_t index, bool writable) override;
     void bindUniformBuffer(Buffer buffer, uint32_t index) override;
     void bindIndexBuffer(Buffer buffer) override;
     void bindVertexBuffer(Buffer buffer) override;
     void bindSampler(Sampler sampler, uint32_t index) override;
     void bindTexture(Texture texture, uint32_t index) override;
     void bindRenderTarget(RenderTarget target) override;
+    void bindImage(Texture texture, uint32_t unit, int level, int layer, ImageAccess access, PixelFormat format) override;
+
+    void bindGroup(BindGroup group, uint32_t set) override;
 
     void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) override;
+    void generateMipmaps(Texture texture) override;
+    void copyTexture(Texture src, int src_level, int sx, int sy, int sz, Texture dst, int dst_level, int dx, int dy, int dz, int width, int height, int depth) override;
     void copyRenderTarget(RenderTarget src, RenderTarget dst, int sx0, int sy0, int sx1, int sy1, int dx0, int dy0, int dx1, int dy1, RenderTargetMask mask, bool filter) override;
 
     void draw(size_t vertices, size_t instances, size_t base_vertex, size_t base_instance) override;
     void idraw(size_t indices, size_t instances, size_t base_index, size_t base_vertex, size_t base_instance) override;
 
+    void dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void dispatchIndirect(Buffer buffer, size_t offset) override;
+    void memoryBarrier(BarrierMask mask) override;
+
+    void beginTimer(const char *name) override;
+    void endTimer() override;
+
+    void pushDebugGroup(const char *name) override;
+    void popDebugGroup() override;
+
 public:
     std::vector<Command> commands;
     size_t num_commands;
+    uint32_t pass_target;
+    uint32_t pass_discard;
+    std::vector<std::string> names;
+    std::vector<BindGroup> groups; // commands only keep raw pointers
 };
 
 class RenderDeviceImpl final : public IRenderDevice {
@@ -194,18 +345,39 @@ public:
     virtual ~RenderDeviceImpl();
 
     const DeviceInfo &getInfo() const;
+    const CacheStats &getCacheStats() const override;
+    size_t getNumBarriers() const override;
+    double getFrameWaitTime() const override;
+    const FrameStats &getFrameStats() const override;
+    size_t getNumTimerResults() const override;
+    const TimerResult &getTimerResult(size_t index) const override;
 
     Shader createShader(const ShaderCreateInfo &info) override;
+    Shader createShaderAsync(const ShaderCreateInfo &info) override;
+    ShaderStatus getShaderStatus(Shader shader) override;
     Pipeline createPipeline(const PipelineCreateInfo &info) override;
+    ShaderStatus getPipelineStatus(Pipeline pipeline) override;
     Buffer createBuffer(const BufferCreateInfo &info) override;
     Sampler createSampler(const SamplerCreateInfo &info) override;
     Texture createTexture(const TextureCreateInfo &info) override;
     RenderTarget createRenderTarget(const RenderTargetCreateInfo &info) override;
+    BindGroup createBindGroup(const BindGroupCreateInfo &info) override;
+
+    TransientTarget acquireTransientTarget(const TransientTargetCreateInfo &info) override;
+    void releaseTransientTarget(const TransientTarget &target) override;
 
     void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) override;
-    void writeTexture2D(Texture texture, int x, int y, int w, int h, PixelFormat format, const void *data) override;
-    void writeTextureCube(Texture texture, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
-    void writeTextureArray(Texture texture, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+    void writeTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    void writeTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    void writeTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+
+    UploadTicket uploadTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    UploadTicket uploadTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    UploadTicket uploadTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+    bool isUploadComplete(UploadTicket ticket) override;
+
+    BindlessTexture createBindlessTexture(Texture texture, Sampler sampler) override;
+    void destroyBindlessTexture(BindlessTexture index) override;
 
     ICommandList *createCommandList() override;
     void destroyCommandList(ICommandList *commands) override;
@@ -227,5 +399,38 @@ public:
     std::vector<Pipeline_S *> pipelines;
     std::vector<Buffer_S *> buffers;
     std::vector<CommandListImpl *> commandlists;
+    std::vector<TransientTargetEntry> transient_targets;
+    uint64_t frame_count;
+    FrameStats frame_stats;
+    FrameStats last_frame_stats;
+    uint64_t next_object_id;
+    CacheStats cache_stats;
+    struct {
+        std::unordered_multimap<uint64_t, CacheEntry<Shader_S>> shaders;
+        std::unordered_multimap<uint64_t, CacheEntry<Pipeline_S>> pipelines;
+        std::unordered_multimap<uint64_t, CacheEntry<Sampler_S>> samplers;
+    } object_cache;
+    std::string shader_prologues[NUM_SHADER_STAGES];
+    uint32_t copy_fbos[2];
+    uint32_t bound_target; // so blits don't have to ask GL
+    struct {
+        uint32_t bufobj;
+        size_t size;
+        size_t head;
+        UploadTicket last_ticket;
+        UploadTicket completed;
+        std::deque<UploadRegion> regions;
+    } upload;
+    struct {
+        std::deque<GLsync> fences;
+        double wait_time;
+    } pacing;
+    struct {
+        std::vector<uint32_t> free_queries;
+        std::deque<TimerFrame> frames;
+        std::vector<size_t> open;
+        std::vector<std::string> names;
+        std::vector<TimerResult> results;
+    } timers;
 };
 } // namespace uvre
@@ -12,8 +12,19 @@
 
 static uvre::VertexArray_S dummy_vao = { 0, 0, 0, nullptr };
 
-static void GLAPIENTRY debugCallback(GLenum, GLenum, GLuint, GLenum severity, GLsizei, const char *message, const void *arg)
+static void setObjectLabel(uint32_t identifier, uint32_t name, const char *label)
 {
+    if(!GLAD_GL_KHR_debug || !label || !label[0])
+        return;
+    glObjectLabel(identifier, name, -1, label);
+}
+
+static void GLAPIENTRY debugCallback(GLenum, GLenum type, GLuint, GLenum severity, GLsizei, const char *message, const void *arg)
+{
+    // Debug groups echo themselves back, that's just noise
+    if(type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP)
+        return;
+
     const uvre::RenderDeviceImpl *device = reinterpret_cast<const uvre::RenderDeviceImpl *>(arg);
         if(device && device->create_info.onDebugMessage) {
 
@@ -39,14 +50,32 @@ static void GLAPIENTRY debugCallback(GLenum, GLenum, GLuint, GLenum severity, GL
     }
 }
 
-static void destroyShader(uvre::Shader_S *shader)
+// Runs from the deleters, so the object is already expired
+template<typename T>
+static void eraseCached(std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash)
+{
+    auto range = cache.equal_range(hash);
+    while(range.first != range.second) {
+        if(range.first->second.object.expired()) {
+            range.first = cache.erase(range.first);
+            continue;
+        }
+
+        range.first++;
+    }
+}
+
+static void destroyShader(uvre::Shader_S *shader, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.shaders, shader->key_hash);
     glDeleteShader(shader->shader);
     delete shader;
 }
 
 static void destroyPipeline(uvre::Pipeline_S *pipeline, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.pipelines, pipeline->key_hash);
+
     // Remove ourselves from the notify list.
     for(std::vector<uvre::Pipeline_S *>::const_iterator it = device->pipelines.cbegin(); it != device->pipelines.cend(); it++) {
         if(*it != pipeline)
@@ -82,8 +111,9 @@ static void destroyBuffer(uvre::Buffer_S *buffer, uvre::RenderDeviceImpl *device
     delete buffer;
 }
 
-static void destroySampler(uvre::Sampler_S *sampler)
+static void destroySampler(uvre::Sampler_S *sampler, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.samplers, sampler->key_hash);
     glDeleteSamplers(1, &sampler->ssobj);
     delete sampler;
 }
@@ -94,14 +124,175 @@ static void destroyTexture(uvre::Texture_S *texture)
     delete texture;
 }
 
-static void destroyRenderTarget(uvre::RenderTarget_S *target)
+static void destroyRenderTarget(uvre::RenderTarget_S *target, uvre::RenderDeviceImpl *device)
 {
+    // Deleting the bound framebuffer reverts to the default one
+    if(device->bound_target == target->fbobj)
+        device->bound_target = 0;
     glDeleteFramebuffers(1, &target->fbobj);
     delete target;
 }
 
+static bool isExtensionSupported(const char *name)
+{
+    int32_t num_extensions;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for(int32_t i = 0; i < num_extensions; i++) {
+        if(!std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))), name))
+            return true;
+    }
+
+    return false;
+}
+
+static constexpr const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+static constexpr const uint64_t FNV_PRIME = 0x100000001B3;
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+template<typename T>
+static void appendKey(std::string &key, const T &value)
+{
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static std::shared_ptr<T> findCached(const std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash, const std::string &key, size_t &hits, size_t &misses)
+{
+    const auto range = cache.equal_range(hash);
+    for(auto it = range.first; it != range.second; it++) {
+        if(it->second.key != key)
+            continue;
+
+        std::shared_ptr<T> object = it->second.object.lock();
+        if(object) {
+            hits++;
+            return object;
+        }
+    }
+
+    misses++;
+    return nullptr;
+}
+
+template<typename T>
+static void insertCached(std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash, const std::string &key, const std::shared_ptr<T> &object)
+{
+    object->key_hash = hash;
+    cache.emplace(hash, uvre::CacheEntry<T> { key, object });
+}
+
+// Sources don't need a terminator when the size is known
+static size_t getCodeSize(const uvre::ShaderCreateInfo &info)
+{
+    if(info.code_size || info.format != uvre::ShaderFormat::SOURCE_GLSL)
+        return info.code_size;
+    return std::strlen(reinterpret_cast<const char *>(info.code));
+}
+
+static const char *getEntryPoint(const uvre::ShaderCreateInfo &info)
+{
+    return info.entry_point ? info.entry_point : "main";
+}
+
+// Keys are built field by field so that struct padding
+// doesn't make identical create infos look different.
+static std::string getShaderKey(const uvre::ShaderCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.stage);
+    appendKey(key, info.format);
+    key.append(reinterpret_cast<const char *>(info.code), getCodeSize(info));
+    key.append(getEntryPoint(info));
+    key.push_back(0);
+    for(size_t i = 0; i < info.num_constants; i++) {
+        appendKey(key, info.constants[i].id);
+        appendKey(key, info.constants[i].value);
+    }
+    return key;
+}
+
+static std::string getPipelineKey(const uvre::PipelineCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.blending.enabled);
+    appendKey(key, info.blending.equation);
+    appendKey(key, info.blending.sfactor);
+    appendKey(key, info.blending.dfactor);
+    appendKey(key, info.depth_testing.enabled);
+    appendKey(key, info.depth_testing.func);
+    appendKey(key, info.face_culling.enabled);
+    appendKey(key, info.face_culling.flags);
+    appendKey(key, info.scissor_test);
+    appendKey(key, info.index_type);
+    appendKey(key, info.primitive_mode);
+    appendKey(key, info.fill_mode);
+    appendKey(key, info.vertex_stride);
+    appendKey(key, info.num_vertex_attribs);
+    for(size_t i = 0; i < info.num_vertex_attribs; i++) {
+        appendKey(key, info.vertex_attribs[i].id);
+        appendKey(key, info.vertex_attribs[i].type);
+        appendKey(key, info.vertex_attribs[i].count);
+        appendKey(key, info.vertex_attribs[i].offset);
+        appendKey(key, info.vertex_attribs[i].normalized);
+    }
+
+    // Object IDs are never reused, unlike GL names or addresses
+    appendKey(key, info.num_shaders);
+    for(size_t i = 0; i < info.num_shaders; i++)
+        appendKey(key, info.shaders[i] ? info.shaders[i]->id : 0);
+    appendKey(key, info.placeholder ? info.placeholder->id : 0);
+    return key;
+}
+
+static std::string getSamplerKey(const uvre::SamplerCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.flags);
+    appendKey(key, info.aniso_level);
+    appendKey(key, info.min_lod);
+    appendKey(key, info.max_lod);
+    appendKey(key, info.lod_bias);
+    return key;
+}
+
+// Everything prepended to GLSL sources only
+// depends on the stage, so it's built once.
+static std::string getShaderPrologue(uvre::ShaderStage stage)
+{
+    std::stringstream ss;
+    ss << "#version 330 core" << std::endl;
+    ss << "#define _UVRE_ 1" << std::endl;
+
+    switch(stage) {
+        case uvre::ShaderStage::VERTEX:
+            ss << "#define _VERTEX_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::GEOMETRY:
+            ss << "#define _GEOMETRY_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::FRAGMENT:
+            ss << "#define _FRAGMENT_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::COMPUTE:
+            break;
+    }
+
+    ss << "#define _GLSL_ 1" << std::endl;
+    return ss.str();
+}
+
 uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_info)
-    : create_info(create_info), vbos(nullptr), bound_pipeline(), null_pipeline(), pipelines(), buffers(), commandlists()
+    : create_info(create_info), vbos(nullptr), bound_pipeline(), null_pipeline(), pipelines(), buffers(), commandlists(), transient_targets(), frame_count(0), frame_stats(), last_frame_stats(), next_object_id(1), cache_stats(), object_cache(), copy_fbos(), bound_target(0), upload(), pacing(), timers()
 {
     glGetIntegerv(GL_MAX_VERTEX_ATTRIB_BINDINGS, &max_vbo_bindings);
 
@@ -111,6 +302,10 @@ uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_in
     info.impl_version_minor = 3;
     info.supports_anisotropic = false;
     info.supports_storage_buffers = false;
+    info.supports_compute = false;
+    info.supports_compression_s3tc = isExtensionSupported("GL_EXT_texture_compression_s3tc");
+    info.supports_compression_rgtc = true;
+    info.supports_compression_bptc = isExtensionSupported("GL_ARB_texture_compression_bptc");
     info.supports_shader_format[static_cast<int>(uvre::ShaderFormat::SOURCE_GLSL)] = true;
 
     null_pipeline.blending.enabled = false;
@@ -125,6 +320,9 @@ uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_in
     null_pipeline.vaos = nullptr;
     bound_pipeline = null_pipeline;
 
+    for(size_t i = 0; i < uvre::NUM_SHADER_STAGES; i++)
+        shader_prologues[i] = getShaderPrologue(static_cast<uvre::ShaderStage>(i));
+
     vbos = new uvre::VBOBinding;
     vbos->index = 0;
     vbos->is_free = true;
@@ -143,6 +341,14 @@ uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_in
             create_info.onDebugMessage(msg);
         }
     }
+
+    if(create_info.upload_buffer_size) {
+        upload.size = create_info.upload_buffer_size;
+        glGenBuffers(1, &upload.bufobj);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.bufobj);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(upload.size), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
 }
 
 uvre::RenderDeviceImpl::~RenderDeviceImpl()
@@ -153,6 +359,31 @@ uvre::RenderDeviceImpl::~RenderDeviceImpl()
     pipelines.clear();
     buffers.clear();
     commandlists.clear();
+    transient_targets.clear();
+
+    for(const uvre::UploadRegion &region : upload.regions)
+        glDeleteSync(region.fence);
+    upload.regions.clear();
+
+    for(GLsync fence : pacing.fences)
+        glDeleteSync(fence);
+    pacing.fences.clear();
+
+    for(const uvre::TimerFrame &frame : timers.frames) {
+        for(const uvre::TimerRegion &region : frame.regions)
+            glDeleteQueries(2, region.queries);
+    }
+
+    if(!timers.free_queries.empty())
+        glDeleteQueries(static_cast<GLsizei>(timers.free_queries.size()), timers.free_queries.data());
+    timers.frames.clear();
+    timers.free_queries.clear();
+
+    if(upload.bufobj)
+        glDeleteBuffers(1, &upload.bufobj);
+
+    if(copy_fbos[0])
+        glDeleteFramebuffers(2, copy_fbos);
 
     // Make sure that the GL context doesn't use it anymore
     glDisable(GL_DEBUG_OUTPUT);
@@ -164,36 +395,77 @@ const uvre::DeviceInfo &uvre::RenderDeviceImpl::getInfo() const
     return info;
 }
 
+const uvre::CacheStats &uvre::RenderDeviceImpl::getCacheStats() const
+{
+    return cache_stats;
+}
+
+double uvre::RenderDeviceImpl::getFrameWaitTime() const
+{
+    return pacing.wait_time;
+}
+
+const uvre::FrameStats &uvre::RenderDeviceImpl::getFrameStats() const
+{
+    return last_frame_stats;
+}
+
+size_t uvre::RenderDeviceImpl::getNumTimerResults() const
+{
+    return timers.results.size();
+}
+
+const uvre::TimerResult &uvre::RenderDeviceImpl::getTimerResult(size_t index) const
+{
+    return timers.results[index];
+}
+
+size_t uvre::RenderDeviceImpl::getNumBarriers() const
+{
+    // Nothing here needs them
+    return 0;
+}
+
 uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &info)
 {
-    std::stringstream ss;
-    ss << "#version 330 core" << std::endl;
-    ss << "#define _UVRE_ 1" << std::endl;
+    const std::string key = getShaderKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Shader cached = findCached(object_cache.shaders, key_hash, key, cache_stats.shader_hits, cache_stats.shader_misses);
+    if(cached)
+        return cached;
 
     uint32_t stage = 0;
     switch(info.stage) {
         case uvre::ShaderStage::VERTEX:
             stage = GL_VERTEX_SHADER;
-            ss << "#define _VERTEX_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::GEOMETRY:
+            stage = GL_GEOMETRY_SHADER;
             break;
         case uvre::ShaderStage::FRAGMENT:
             stage = GL_FRAGMENT_SHADER;
-            ss << "#define _FRAGMENT_SHADER_ 1" << std::endl;
             break;
+        case uvre::ShaderStage::COMPUTE:
+            // Not core in GL 3.3
+            return nullptr;
     }
 
     int32_t status, info_log_length;
     std::string info_log;
     uint32_t shobj = glCreateShader(stage);
-    const char *source_cstr;
-    std::string source;
+    setObjectLabel(GL_SHADER, shobj, info.debug_name);
+    const char *sources[2];
+    int32_t lengths[2];
 
     switch(info.format) {
         case uvre::ShaderFormat::SOURCE_GLSL:
-            ss << "#define _GLSL_ 1" << std::endl;
-            source = ss.str() + reinterpret_cast<const char *>(info.code);
-            source_cstr = source.c_str();
-            glShaderSource(shobj, 1, &source_cstr, nullptr);
+            // The prologue and the user's code go in as
+            // separate strings so that nothing is copied.
+            sources[0] = shader_prologues[static_cast<size_t>(info.stage)].c_str();
+            sources[1] = reinterpret_cast<const char *>(info.code);
+            lengths[0] = static_cast<int32_t>(shader_prologues[static_cast<size_t>(info.stage)].size());
+            lengths[1] = static_cast<int32_t>(getCodeSize(info));
+            glShaderSource(shobj, 2, sources, lengths);
             glCompileShader(shobj);
             break;
         default:
@@ -220,13 +492,27 @@ uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &
         return nullptr;
     }
 
-    uvre::Shader shader(new uvre::Shader_S, destroyShader);
+    uvre::Shader shader(new uvre::Shader_S, std::bind(destroyShader, std::placeholders::_1, this));
+    shader->id = next_object_id++;
     shader->shader = shobj;
     shader->stage = info.stage;
+    insertCached(object_cache.shaders, key_hash, key, shader);
 
     return shader;
 }
 
+uvre::Shader uvre::RenderDeviceImpl::createShaderAsync(const uvre::ShaderCreateInfo &info)
+{
+    // Pipelines link their programs in createPipeline
+    // so there's not much to gain from going async here.
+    return createShader(info);
+}
+
+uvre::ShaderStatus uvre::RenderDeviceImpl::getShaderStatus(uvre::Shader shader)
+{
+    return shader ? uvre::ShaderStatus::READY : uvre::ShaderStatus::FAILED;
+}
+
 static inline uint32_t getBlendEquation(uvre::BlendEquation equation)
 {
     switch(equation) {
@@ -423,9 +709,17 @@ static inline uvre::VertexArray_S *getVertexArray(uvre::VertexArray_S **head, ui
 
 uvre::Pipeline uvre::RenderDeviceImpl::createPipeline(const uvre::PipelineCreateInfo &info)
 {
+    const std::string key = getPipelineKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Pipeline cached = findCached(object_cache.pipelines, key_hash, key, cache_stats.pipeline_hits, cache_stats.pipeline_misses);
+    if(cached)
+        return cached;
+
     uvre::Pipeline pipeline(new uvre::Pipeline_S, std::bind(destroyPipeline, std::placeholders::_1, this));
+    pipeline->id = next_object_id++;
 
     pipeline->program = glCreateProgram();
+    setObjectLabel(GL_PROGRAM, pipeline->program, info.debug_name);
     for(size_t i = 0; i < info.num_shaders; i++)
         glAttachShader(pipeline->program, info.shaders[i]->shader);
     glLinkProgram(pipeline->program);
@@ -487,10 +781,16 @@ uvre::Pipeline uvre::RenderDeviceImpl::createPipeline(const uvre::PipelineCreate
 
     // Add ourselves to the notify list.
     pipelines.push_back(pipeline.get());
+    insertCached(object_cache.pipelines, key_hash, key, pipeline);
 
     return pipeline;
 }
 
+uvre::ShaderStatus uvre::RenderDeviceImpl::getPipelineStatus(uvre::Pipeline pipeline)
+{
+    return pipeline ? uvre::ShaderStatus::READY : uvre::ShaderStatus::FAILED;
+}
+
 static uvre::VBOBinding *getFreeVBOBinding(uvre::VBOBinding **head)
 {
     for(uvre::VBOBinding *node = *head; node; node = node->next) {
@@ -533,6 +833,7 @@ uvre::Buffer uvre::RenderDeviceImpl::createBuffer(const uvre::BufferCreateInfo &
 
     glBindBuffer(GL_COPY_READ_BUFFER, buffer->bufobj);
     glBufferData(GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>(buffer->size), info.data, GL_DYNAMIC_DRAW);
+    setObjectLabel(GL_BUFFER, buffer->bufobj, info.debug_name);
     return buffer;
 }
 
@@ -540,12 +841,20 @@ void uvre::RenderDeviceImpl::writeBuffer(uvre::Buffer buffer, size_t offset, siz
 {
     if(offset + size > buffer->size)
         return;
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += size;
     glBindBuffer(GL_COPY_READ_BUFFER, buffer->bufobj);
     glBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
 }
 
 uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInfo &info)
 {
+    const std::string key = getSamplerKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Sampler cached = findCached(object_cache.samplers, key_hash, key, cache_stats.sampler_hits, cache_stats.sampler_misses);
+    if(cached)
+        return cached;
+
     uint32_t ssobj;
     glGenSamplers(1, &ssobj);
 
@@ -554,11 +863,11 @@ uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInf
     glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_R, (info.flags & SAMPLER_CLAMP_R) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
 
     if(info.flags & SAMPLER_FILTER) {
-        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, (info.flags & SAMPLER_MIPMAP) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         glSamplerParameterf(ssobj, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
     else {
-        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, (info.flags & SAMPLER_MIPMAP) ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
         glSamplerParameterf(ssobj, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
 
@@ -566,8 +875,10 @@ uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInf
     glSamplerParameterf(ssobj, GL_TEXTURE_MAX_LOD, info.max_lod);
     glSamplerParameterf(ssobj, GL_TEXTURE_LOD_BIAS, info.lod_bias);
 
-    uvre::Sampler sampler(new uvre::Sampler_S, destroySampler);
+    uvre::Sampler sampler(new uvre::Sampler_S, std::bind(destroySampler, std::placeholders::_1, this));
     sampler->ssobj = ssobj;
+    insertCached(object_cache.samplers, key_hash, key, sampler);
+    setObjectLabel(GL_SAMPLER, ssobj, info.debug_name);
 
     return sampler;
 }
@@ -661,41 +972,219 @@ static inline uint32_t getInternalFormat(uvre::PixelFormat format)
             return GL_DEPTH_COMPONENT32F;
         case uvre::PixelFormat::S8_UINT:
             return GL_STENCIL_INDEX8;
+        case uvre::PixelFormat::BC1_UNORM:
+            return uvre::COMPRESSED_RGBA_S3TC_DXT1;
+        case uvre::PixelFormat::BC3_UNORM:
+            return uvre::COMPRESSED_RGBA_S3TC_DXT5;
+        case uvre::PixelFormat::BC4_UNORM:
+            return GL_COMPRESSED_RED_RGTC1;
+        case uvre::PixelFormat::BC4_SNORM:
+            return GL_COMPRESSED_SIGNED_RED_RGTC1;
+        case uvre::PixelFormat::BC5_UNORM:
+            return GL_COMPRESSED_RG_RGTC2;
+        case uvre::PixelFormat::BC5_SNORM:
+            return GL_COMPRESSED_SIGNED_RG_RGTC2;
+        case uvre::PixelFormat::BC7_UNORM:
+            return uvre::COMPRESSED_RGBA_BPTC_UNORM;
         default:
             return 0;
     }
 }
 
+static bool getCompressedFormat(uvre::PixelFormat format, uint32_t &internal_format, size_t &block_size)
+{
+    switch(format) {
+        case uvre::PixelFormat::BC1_UNORM:
+            internal_format = uvre::COMPRESSED_RGBA_S3TC_DXT1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC3_UNORM:
+            internal_format = uvre::COMPRESSED_RGBA_S3TC_DXT5;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC4_UNORM:
+            internal_format = GL_COMPRESSED_RED_RGTC1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC4_SNORM:
+            internal_format = GL_COMPRESSED_SIGNED_RED_RGTC1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC5_UNORM:
+            internal_format = GL_COMPRESSED_RG_RGTC2;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC5_SNORM:
+            internal_format = GL_COMPRESSED_SIGNED_RG_RGTC2;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC7_UNORM:
+            internal_format = uvre::COMPRESSED_RGBA_BPTC_UNORM;
+            block_size = 16;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline size_t getCompressedSize(size_t block_size, int w, int h, int d)
+{
+    const size_t blocks_x = static_cast<size_t>(w + 3) / 4;
+    const size_t blocks_y = static_cast<size_t>(h + 3) / 4;
+    return blocks_x * blocks_y * static_cast<size_t>(d) * block_size;
+}
+
+static bool isBlockAligned(const uvre::Texture_S *texture, int level, int x, int y, int w, int h)
+{
+    // Compressed regions must start on a block boundary and
+    // may only end off one when they touch the edge of the level.
+    const int level_width = std::max(1, texture->width >> level);
+    const int level_height = std::max(1, texture->height >> level);
+    if(x < 0 || y < 0 || x % 4 || y % 4)
+        return false;
+    if(w % 4 && x + w != level_width)
+        return false;
+    if(h % 4 && y + h != level_height)
+        return false;
+    return true;
+}
+
+// Returns false for formats that aren't compressed. Compressed writes
+// come back with a zero size when they don't fit the texture's blocks.
+static bool getCompressedWrite(const uvre::Texture_S *texture, uvre::PixelFormat format, int level, int x, int y, int w, int h, int d, uint32_t &internal_format, GLsizei &size)
+{
+    size_t block_size;
+    if(!getCompressedFormat(format, internal_format, block_size))
+        return false;
+    if(internal_format != texture->format || !isBlockAligned(texture, level, x, y, w, h))
+        size = 0;
+    else
+        size = static_cast<GLsizei>(getCompressedSize(block_size, w, h, d));
+    return true;
+}
+
+static bool isCompressionSupported(const uvre::DeviceInfo &info, uvre::PixelFormat format)
+{
+    switch(format) {
+        case uvre::PixelFormat::BC1_UNORM:
+        case uvre::PixelFormat::BC3_UNORM:
+            return info.supports_compression_s3tc;
+        case uvre::PixelFormat::BC4_UNORM:
+        case uvre::PixelFormat::BC4_SNORM:
+        case uvre::PixelFormat::BC5_UNORM:
+        case uvre::PixelFormat::BC5_SNORM:
+            return info.supports_compression_rgtc;
+        case uvre::PixelFormat::BC7_UNORM:
+            return info.supports_compression_bptc;
+        default:
+            return true;
+    }
+}
+
+static uint32_t getStorageFormat(uvre::PixelFormat format)
+{
+    // Without glTexStorage the external format still has
+    // to be compatible with the internal one, even if no
+    // pixel data is actually being passed.
+    switch(format) {
+        case uvre::PixelFormat::R8_SINT:
+        case uvre::PixelFormat::R8_UINT:
+        case uvre::PixelFormat::R8G8_SINT:
+        case uvre::PixelFormat::R8G8_UINT:
+        case uvre::PixelFormat::R8G8B8_SINT:
+        case uvre::PixelFormat::R8G8B8_UINT:
+        case uvre::PixelFormat::R8G8B8A8_SINT:
+        case uvre::PixelFormat::R8G8B8A8_UINT:
+        case uvre::PixelFormat::R16_SINT:
+        case uvre::PixelFormat::R16_UINT:
+        case uvre::PixelFormat::R16G16_SINT:
+        case uvre::PixelFormat::R16G16_UINT:
+        case uvre::PixelFormat::R16G16B16_SINT:
+        case uvre::PixelFormat::R16G16B16_UINT:
+        case uvre::PixelFormat::R16G16B16A16_SINT:
+        case uvre::PixelFormat::R16G16B16A16_UINT:
+        case uvre::PixelFormat::R32_SINT:
+        case uvre::PixelFormat::R32_UINT:
+        case uvre::PixelFormat::R32G32_SINT:
+        case uvre::PixelFormat::R32G32_UINT:
+        case uvre::PixelFormat::R32G32B32_SINT:
+        case uvre::PixelFormat::R32G32B32_UINT:
+        case uvre::PixelFormat::R32G32B32A32_SINT:
+        case uvre::PixelFormat::R32G32B32A32_UINT:
+            return GL_RED_INTEGER;
+        case uvre::PixelFormat::D16_UNORM:
+        case uvre::PixelFormat::D32_FLOAT:
+            return GL_DEPTH_COMPONENT;
+        case uvre::PixelFormat::S8_UINT:
+            return GL_STENCIL_INDEX;
+        default:
+            return GL_RED;
+    }
+}
+
 uvre::Texture uvre::RenderDeviceImpl::createTexture(const uvre::TextureCreateInfo &info)
 {
     uint32_t texobj;
     uint32_t format = getInternalFormat(info.format);
+    uint32_t storage_format = getStorageFormat(info.format);
     uint32_t target;
     int32_t mip_levels = std::max<int32_t>(1, static_cast<int32_t>(info.mip_levels));
+    uint32_t compressed_format;
+    size_t block_size;
+
+    if(!isCompressionSupported(this->info, info.format))
+        return nullptr;
 
-    // TODO: account mip levels somehow
+    // Compressed formats get their storage allocated with
+    // glCompressedTexImage so no implicit compression happens.
+    const bool compressed = getCompressedFormat(info.format, compressed_format, block_size);
+    const auto allocate2D = [&](uint32_t image_target, int32_t level) {
+        const int width = std::max(1, info.width >> level);
+        const int height = std::max(1, info.height >> level);
+        if(compressed)
+            glCompressedTexImage2D(image_target, level, format, width, height, 0, static_cast<GLsizei>(getCompressedSize(block_size, width, height, 1)), nullptr);
+        else
+            glTexImage2D(image_target, level, format, width, height, 0, storage_format, GL_UNSIGNED_BYTE, nullptr);
+    };
 
     glGenTextures(1, &texobj);
     switch(info.type) {
         case uvre::TextureType::TEXTURE_2D:
             target = GL_TEXTURE_2D;
             glBindTexture(target, texobj);
-            glTexImage2D(target, 0, format, info.width, info.height, 0, GL_RED, GL_FLOAT, nullptr);
+            for(int32_t i = 0; i < mip_levels; i++)
+                allocate2D(target, i);
             break;
         case uvre::TextureType::TEXTURE_CUBE:
             target = GL_TEXTURE_CUBE_MAP;
             glBindTexture(target, texobj);
-            glTexImage2D(target, 0, format, info.width, info.height, 0, GL_RED, GL_FLOAT, nullptr);
+            for(int32_t i = 0; i < mip_levels; i++) {
+                for(uint32_t face = 0; face < 6; face++)
+                    allocate2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, i);
+            }
             break;
         case uvre::TextureType::TEXTURE_ARRAY:
             target = GL_TEXTURE_2D_ARRAY;
             glBindTexture(target, texobj);
-            glTexImage3D(target, 0, format, info.width, info.height, info.depth, 0, GL_RED, GL_FLOAT, nullptr);
+            for(int32_t i = 0; i < mip_levels; i++) {
+                const int width = std::max(1, info.width >> i);
+                const int height = std::max(1, info.height >> i);
+                if(compressed)
+                    glCompressedTexImage3D(target, i, format, width, height, info.depth, 0, static_cast<GLsizei>(getCompressedSize(block_size, width, height, info.depth)), nullptr);
+                else
+                    glTexImage3D(target, i, format, width, height, info.depth, 0, storage_format, GL_UNSIGNED_BYTE, nullptr);
+            }
             break;
         default:
+            glDeleteTextures(1, &texobj);
             return nullptr;
     }
 
+    // Otherwise the texture is incomplete unless
+    // every single level down to 1x1 is allocated.
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mip_levels - 1);
+
     uvre::Texture texture(new uvre::Texture_S, destroyTexture);
     texture->texobj = texobj;
     texture->format = format;
@@ -703,6 +1192,9 @@ uvre::Texture uvre::RenderDeviceImpl::createTexture(const uvre::TextureCreateInf
     texture->width = info.width;
     texture->height = info.height;
     texture->depth = info.depth;
+    texture->levels = mip_levels;
+    texture->compressed = compressed;
+    setObjectLabel(GL_TEXTURE, texobj, info.debug_name);
 
     return texture;
 }
@@ -820,31 +1312,322 @@ static bool getExternalFormat(uvre::PixelFormat format, uint32_t &fmt, uint32_t
     return true;
 }
 
-void uvre::RenderDeviceImpl::writeTexture2D(uvre::Texture texture, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+static size_t getUploadSize(uint32_t fmt, uint32_t type, int w, int h, int d)
+{
+    size_t components = 0;
+    switch(fmt) {
+        case GL_RED:
+            components = 1;
+            break;
+        case GL_RG:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        case GL_RGBA:
+            components = 4;
+            break;
+    }
+
+    size_t type_size = 0;
+    switch(type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            type_size = 1;
+            break;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            type_size = 2;
+            break;
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            type_size = 4;
+            break;
+    }
+
+    // GL_UNPACK_ALIGNMENT is never changed so rows
+    // are padded to four bytes, except for the last one.
+    const size_t row_size = static_cast<size_t>(w) * components * type_size;
+    const size_t row_pitch = (row_size + 3) & ~static_cast<size_t>(3);
+    const size_t rows = static_cast<size_t>(h) * static_cast<size_t>(d);
+    return rows ? row_pitch * (rows - 1) + row_size : 0;
+}
+
+void uvre::RenderDeviceImpl::writeTexture2D(uvre::Texture texture, int level, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glBindTexture(GL_TEXTURE_2D, texture->texobj);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
     glBindTexture(GL_TEXTURE_2D, texture->texobj);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, fmt, type, data);
 }
 
-void uvre::RenderDeviceImpl::writeTextureCube(uvre::Texture texture, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+void uvre::RenderDeviceImpl::writeTextureCube(uvre::Texture texture, int level, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture->texobj);
+        glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, x, y, w, h, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
     glBindTexture(GL_TEXTURE_CUBE_MAP, texture->texobj);
-    glTexSubImage3D(GL_TEXTURE_CUBE_MAP, 0, x, y, face, w, h, 1, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, 1);
+    glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, x, y, w, h, fmt, type, data);
 }
 
-void uvre::RenderDeviceImpl::writeTextureArray(uvre::Texture texture, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
+void uvre::RenderDeviceImpl::writeTextureArray(uvre::Texture texture, int level, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, d, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture->texobj);
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, z, w, h, d, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
     glBindTexture(GL_TEXTURE_2D_ARRAY, texture->texobj);
-    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, z, w, h, d, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, d);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, z, w, h, d, fmt, type, data);
+}
+
+static bool retireUpload(uvre::RenderDeviceImpl *device, GLuint64 timeout)
+{
+    if(device->upload.regions.empty())
+        return false;
+
+    const uvre::UploadRegion &region = device->upload.regions.front();
+    GLenum result = glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(region.fence);
+    device->upload.completed = region.ticket;
+    device->upload.regions.pop_front();
+    return true;
+}
+
+static size_t allocUpload(uvre::RenderDeviceImpl *device, size_t size)
+{
+    for(;;) {
+        // Find the oldest region that still occupies memory.
+        const uvre::UploadRegion *tail = nullptr;
+        for(const uvre::UploadRegion &region : device->upload.regions) {
+            if(!region.size)
+                continue;
+            tail = &region;
+            break;
+        }
+
+        if(!tail)
+            return 0;
+
+        // Strict comparisons here make sure that the head
+        // never catches up with the tail after wrapping around.
+        if(device->upload.head >= tail->offset) {
+            if(device->upload.head + size <= device->upload.size)
+                return device->upload.head;
+            if(size < tail->offset)
+                return 0;
+        }
+        else if(device->upload.head + size < tail->offset) {
+            return device->upload.head;
+        }
+
+        // The ring is full: we have to wait for the GPU.
+        retireUpload(device, std::numeric_limits<GLuint64>::max());
+    }
+}
+
+static uvre::UploadTicket pushUpload(uvre::RenderDeviceImpl *device, size_t size, const void *data, const std::function<void(const void *)> &write)
+{
+    // Offsets into a pixel unpack buffer must be
+    // aligned to the size of the texel component.
+    const size_t aligned_size = (size + 15) & ~static_cast<size_t>(15);
+
+    uvre::UploadRegion region = {};
+    region.ticket = ++device->upload.last_ticket;
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        device->frame_stats.bytes_written += size;
+
+    if(device->upload.bufobj && aligned_size <= device->upload.size) {
+        region.offset = allocUpload(device, aligned_size);
+        region.size = aligned_size;
+
+        // The range is guaranteed to be unused by the
+        // GPU by now, so there's no need to synchronize.
+        const uint32_t access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, device->upload.bufobj);
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, static_cast<GLintptr>(region.offset), static_cast<GLsizeiptr>(size), access);
+        std::memcpy(mapped, data, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        write(reinterpret_cast<const void *>(static_cast<uintptr_t>(region.offset)));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        device->upload.head = region.offset + aligned_size;
+    }
+    else {
+        // Doesn't fit into the ring, so the driver
+        // has to copy the data the slow way.
+        region.offset = device->upload.head;
+        region.size = 0;
+        write(data);
+    }
+
+    region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    device->upload.regions.push_back(region);
+    return region.ticket;
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTexture2D(uvre::Texture texture, int level, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glBindTexture(GL_TEXTURE_2D, texture->texobj);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, 1), data, [&](const void *pixels) {
+        glBindTexture(GL_TEXTURE_2D, texture->texobj);
+        glTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, fmt, type, pixels);
+    });
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTextureCube(uvre::Texture texture, int level, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, texture->texobj);
+            glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, x, y, w, h, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, 1), data, [&](const void *pixels) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture->texobj);
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, x, y, w, h, fmt, type, pixels);
+    });
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTextureArray(uvre::Texture texture, int level, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, d, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture->texobj);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, z, w, h, d, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, d), data, [&](const void *pixels) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture->texobj);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, z, w, h, d, fmt, type, pixels);
+    });
+}
+
+bool uvre::RenderDeviceImpl::isUploadComplete(uvre::UploadTicket ticket)
+{
+    while(ticket > upload.completed && retireUpload(this, 0))
+        continue;
+    return ticket <= upload.completed;
+}
+
+uvre::BindlessTexture uvre::RenderDeviceImpl::createBindlessTexture(uvre::Texture, uvre::Sampler)
+{
+    // Neither the bindless handles nor the storage
+    // buffer the fallback path indexes exist in 3.3.
+    return 0;
+}
+
+void uvre::RenderDeviceImpl::destroyBindlessTexture(uvre::BindlessTexture)
+{
+}
+
+static void attachTextureLayer(uint32_t fb_target, uint32_t attachment, uint32_t target, uint32_t texobj, int level, int layer)
+{
+    switch(target) {
+        case GL_TEXTURE_CUBE_MAP:
+            glFramebufferTexture2D(fb_target, attachment, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, texobj, level);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            glFramebufferTextureLayer(fb_target, attachment, texobj, level, layer);
+            break;
+        default:
+            glFramebufferTexture2D(fb_target, attachment, target, texobj, level);
+            break;
+    }
+}
+
+static void attachTexture(uint32_t attachment, const uvre::Texture &texture, int level, int layer)
+{
+    if(layer < 0)
+        glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture->texobj, level);
+    else
+        attachTextureLayer(GL_FRAMEBUFFER, attachment, texture->target, texture->texobj, level, layer);
 }
 
 uvre::RenderTarget uvre::RenderDeviceImpl::createRenderTarget(const uvre::RenderTargetCreateInfo &info)
@@ -855,23 +1638,204 @@ uvre::RenderTarget uvre::RenderDeviceImpl::createRenderTarget(const uvre::Render
     glBindFramebuffer(GL_FRAMEBUFFER, fbobj);
 
     if(info.depth_attachment)
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, info.depth_attachment->texobj, 0);
+        attachTexture(GL_DEPTH_ATTACHMENT, info.depth_attachment, info.depth_level, info.depth_layer);
     if(info.stencil_attachment)
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, info.stencil_attachment->texobj, 0);
+        attachTexture(GL_STENCIL_ATTACHMENT, info.stencil_attachment, info.stencil_level, info.stencil_layer);
     for(size_t i = 0; i < info.num_color_attachments; i++)
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + info.color_attachments[i].id, GL_TEXTURE_2D, info.color_attachments[i].color->texobj, 0);
+        attachTexture(GL_COLOR_ATTACHMENT0 + info.color_attachments[i].id, info.color_attachments[i].color, info.color_attachments[i].level, info.color_attachments[i].layer);
+
+    // Map draw buffer N to color attachment N so the
+    // fragment outputs and attachment clears line up.
+    std::vector<uint32_t> draw_buffers;
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        const uint32_t id = info.color_attachments[i].id;
+        if(draw_buffers.size() <= id)
+            draw_buffers.resize(id + 1, GL_NONE);
+        draw_buffers[id] = GL_COLOR_ATTACHMENT0 + id;
+    }
 
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    if(draw_buffers.empty())
+        draw_buffers.push_back(GL_NONE);
+    glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, bound_target);
+    if(!complete) {
         glDeleteFramebuffers(1, &fbobj);
         return nullptr;
     }
 
-    uvre::RenderTarget target(new uvre::RenderTarget_S, destroyRenderTarget);
+    uvre::RenderTarget target(new uvre::RenderTarget_S, std::bind(destroyRenderTarget, std::placeholders::_1, this));
     target->fbobj = fbobj;
+    setObjectLabel(GL_FRAMEBUFFER, fbobj, info.debug_name);
 
     return target;
 }
 
+static void blitTexture(uvre::RenderDeviceImpl *device, const uvre::Command &cmd)
+{
+    // glCopyImageSubData is not a thing in 3.3 so
+    // we blit layer by layer through two framebuffers.
+    uint32_t attachment = GL_COLOR_ATTACHMENT0;
+    uint32_t mask = GL_COLOR_BUFFER_BIT;
+    switch(cmd.tex_copy.format) {
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT32F:
+            attachment = GL_DEPTH_ATTACHMENT;
+            mask = GL_DEPTH_BUFFER_BIT;
+            break;
+        case GL_STENCIL_INDEX8:
+            attachment = GL_STENCIL_ATTACHMENT;
+            mask = GL_STENCIL_BUFFER_BIT;
+            break;
+    }
+
+    if(!device->copy_fbos[0])
+        glGenFramebuffers(2, device->copy_fbos);
+
+    // Blits are clipped by the scissor box
+    if(device->bound_pipeline.scissor_test)
+        glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, device->copy_fbos[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, device->copy_fbos[1]);
+
+    for(int i = 0; i < cmd.tex_copy.d; i++) {
+        attachTextureLayer(GL_READ_FRAMEBUFFER, attachment, cmd.tex_copy.src_target, cmd.tex_copy.src, cmd.tex_copy.src_level, cmd.tex_copy.sz + i);
+        attachTextureLayer(GL_DRAW_FRAMEBUFFER, attachment, cmd.tex_copy.dst_target, cmd.tex_copy.dst, cmd.tex_copy.dst_level, cmd.tex_copy.dz + i);
+        glBlitFramebuffer(cmd.tex_copy.sx, cmd.tex_copy.sy, cmd.tex_copy.sx + cmd.tex_copy.w, cmd.tex_copy.sy + cmd.tex_copy.h, cmd.tex_copy.dx, cmd.tex_copy.dy, cmd.tex_copy.dx + cmd.tex_copy.w, cmd.tex_copy.dy + cmd.tex_copy.h, mask, GL_NEAREST);
+    }
+
+    // Don't keep the textures attached to anything
+    attachTextureLayer(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0, 0);
+    attachTextureLayer(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, device->bound_target);
+    if(device->bound_pipeline.scissor_test)
+        glEnable(GL_SCISSOR_TEST);
+}
+
+static bool compareBindGroupEntries(const uvre::BindGroupEntry &a, const uvre::BindGroupEntry &b)
+{
+    if(a.type != b.type)
+        return a.type < b.type;
+    return a.index < b.index;
+}
+
+static inline uint32_t getSlotBit(uint32_t index)
+{
+    // Everything past the mask shares the last bit
+    return 1U << std::min<uint32_t>(index, 31);
+}
+
+uvre::BindGroup uvre::RenderDeviceImpl::createBindGroup(const uvre::BindGroupCreateInfo &info)
+{
+    uvre::BindGroup group(new uvre::BindGroup_S);
+    group->id = next_object_id++;
+    group->slots = 0;
+    group->entries.assign(info.entries, info.entries + info.num_entries);
+    std::sort(group->entries.begin(), group->entries.end(), compareBindGroupEntries);
+
+    for(const uvre::BindGroupEntry &entry : group->entries) {
+        uvre::BindGroupBinding binding = {};
+        binding.type = entry.type;
+        binding.index = entry.index;
+        switch(entry.type) {
+            case uvre::BindingType::UNIFORM_BUFFER:
+            case uvre::BindingType::STORAGE_BUFFER:
+                if(entry.buffer) {
+                    binding.object = entry.buffer->bufobj;
+                    binding.offset = entry.offset;
+                    binding.size = entry.size ? entry.size : entry.buffer->size - entry.offset;
+                }
+                break;
+            case uvre::BindingType::SAMPLER:
+                binding.object = entry.sampler ? entry.sampler->ssobj : 0;
+                break;
+            case uvre::BindingType::TEXTURE:
+                binding.object = entry.texture ? entry.texture->texobj : 0;
+                binding.target = entry.texture ? entry.texture->target : GL_TEXTURE_2D;
+                break;
+        }
+
+        group->bindings.push_back(binding);
+        group->slots |= getSlotBit(entry.index);
+    }
+
+    return group;
+}
+
+static bool isSameTransientTarget(const uvre::TransientTargetEntry &entry, const uvre::TransientTargetCreateInfo &info)
+{
+    if(entry.width != info.width || entry.height != info.height || entry.num_color_attachments != info.num_color_attachments)
+        return false;
+    if(entry.use_depth != info.use_depth || (info.use_depth && entry.depth_format != info.depth_format))
+        return false;
+    return std::equal(info.color_formats, info.color_formats + info.num_color_attachments, entry.color_formats);
+}
+
+uvre::TransientTarget uvre::RenderDeviceImpl::acquireTransientTarget(const uvre::TransientTargetCreateInfo &info)
+{
+    if(info.num_color_attachments > uvre::MAX_COLOR_ATTACHMENTS)
+        return uvre::TransientTarget {};
+
+    for(uvre::TransientTargetEntry &entry : transient_targets) {
+        if(entry.in_use || !isSameTransientTarget(entry, info))
+            continue;
+        entry.in_use = true;
+        entry.last_frame = frame_count;
+        return entry.target;
+    }
+
+    uvre::TransientTargetEntry entry = {};
+    entry.width = info.width;
+    entry.height = info.height;
+    entry.num_color_attachments = info.num_color_attachments;
+    entry.use_depth = info.use_depth;
+    entry.depth_format = info.depth_format;
+    std::copy(info.color_formats, info.color_formats + info.num_color_attachments, entry.color_formats);
+
+    uvre::TextureCreateInfo texture_info = {};
+    texture_info.type = uvre::TextureType::TEXTURE_2D;
+    texture_info.width = info.width;
+    texture_info.height = info.height;
+
+    uvre::ColorAttachment attachments[uvre::MAX_COLOR_ATTACHMENTS];
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        texture_info.format = info.color_formats[i];
+        entry.target.color[i] = createTexture(texture_info);
+        attachments[i].id = static_cast<uint32_t>(i);
+        attachments[i].color = entry.target.color[i];
+    }
+
+    uvre::RenderTargetCreateInfo target_info = {};
+    target_info.num_color_attachments = info.num_color_attachments;
+    target_info.color_attachments = attachments;
+
+    if(info.use_depth) {
+        texture_info.format = info.depth_format;
+        entry.target.depth = createTexture(texture_info);
+        target_info.depth_attachment = entry.target.depth;
+    }
+
+    entry.target.target = createRenderTarget(target_info);
+    if(!entry.target.target)
+        return uvre::TransientTarget {};
+
+    entry.in_use = true;
+    entry.last_frame = frame_count;
+    transient_targets.push_back(entry);
+    return entry.target;
+}
+
+void uvre::RenderDeviceImpl::releaseTransientTarget(const uvre::TransientTarget &target)
+{
+    for(uvre::TransientTargetEntry &entry : transient_targets) {
+        if(entry.target.target != target.target)
+            continue;
+        entry.in_use = false;
+        return;
+    }
+}
+
 uvre::ICommandList *uvre::RenderDeviceImpl::createCommandList()
 {
     uvre::CommandListImpl *commands = new uvre::CommandListImpl();
@@ -894,15 +1858,223 @@ void uvre::RenderDeviceImpl::startRecording(uvre::ICommandList *commands)
 {
     uvre::CommandListImpl *glcommands = static_cast<uvre::CommandListImpl *>(commands);
     glcommands->num_commands = 0;
+    glcommands->names.clear();
+    glcommands->groups.clear();
+}
+
+static void applyBindGroup(const uvre::BindGroup_S *group)
+{
+    for(const uvre::BindGroupBinding &binding : group->bindings) {
+        switch(binding.type) {
+            case uvre::BindingType::UNIFORM_BUFFER:
+                if(binding.object)
+                    glBindBufferRange(GL_UNIFORM_BUFFER, binding.index, binding.object, static_cast<GLintptr>(binding.offset), static_cast<GLsizeiptr>(binding.size));
+                else
+                    glBindBufferBase(GL_UNIFORM_BUFFER, binding.index, 0);
+                break;
+            case uvre::BindingType::STORAGE_BUFFER:
+                // Not a thing in 3.3
+                break;
+            case uvre::BindingType::SAMPLER:
+                glBindSampler(binding.index, binding.object);
+                break;
+            case uvre::BindingType::TEXTURE:
+                glActiveTexture(GL_TEXTURE0 + binding.index);
+                glBindTexture(binding.target, binding.object);
+                break;
+        }
+    }
+}
+
+static void invalidateBindGroups(const uvre::BindGroup_S **bound_groups, uint32_t slots)
+{
+    for(uint32_t i = 0; i < uvre::MAX_BIND_GROUPS; i++) {
+        if(bound_groups[i] && (bound_groups[i]->slots & slots))
+            bound_groups[i] = nullptr;
+    }
+}
+
+static uint32_t allocTimerQuery(uvre::RenderDeviceImpl *device)
+{
+    if(device->timers.free_queries.empty()) {
+        uint32_t queries[uvre::TIMER_QUERY_BATCH];
+        glGenQueries(static_cast<GLsizei>(uvre::TIMER_QUERY_BATCH), queries);
+        device->timers.free_queries.assign(queries, queries + uvre::TIMER_QUERY_BATCH);
+    }
+
+    const uint32_t query = device->timers.free_queries.back();
+    device->timers.free_queries.pop_back();
+    return query;
+}
+
+static void beginTimer(uvre::RenderDeviceImpl *device, const std::string &name)
+{
+    if(device->timers.frames.empty())
+        device->timers.frames.emplace_back();
+
+    uvre::TimerRegion region = {};
+    region.name = name;
+    region.queries[0] = allocTimerQuery(device);
+    region.queries[1] = allocTimerQuery(device);
+    region.ended = false;
+    glQueryCounter(region.queries[0], GL_TIMESTAMP);
+
+    uvre::TimerFrame &frame = device->timers.frames.back();
+    device->timers.open.push_back(frame.regions.size());
+    frame.regions.push_back(region);
+}
+
+static void endTimer(uvre::RenderDeviceImpl *device)
+{
+    if(device->timers.open.empty() || device->timers.frames.empty())
+        return;
+
+    uvre::TimerRegion &region = device->timers.frames.back().regions[device->timers.open.back()];
+    device->timers.open.pop_back();
+    glQueryCounter(region.queries[1], GL_TIMESTAMP);
+    region.ended = true;
+}
+
+// Frames are read back in order and only once every query
+// is available, so asking for the results never stalls.
+static bool readTimerFrame(uvre::RenderDeviceImpl *device, const uvre::TimerFrame &frame)
+{
+    for(const uvre::TimerRegion &region : frame.regions) {
+        int32_t available = GL_TRUE;
+        if(region.ended)
+            glGetQueryObjectiv(region.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            return false;
+    }
+
+    device->timers.names.clear();
+    device->timers.results.clear();
+    for(const uvre::TimerRegion &region : frame.regions) {
+        if(region.ended) {
+            uint64_t begin, end;
+            glGetQueryObjectui64v(region.queries[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(region.queries[1], GL_QUERY_RESULT, &end);
+            device->timers.names.push_back(region.name);
+            device->timers.results.push_back(uvre::TimerResult { nullptr, static_cast<double>(end - begin) / 1000000.0 });
+        }
+
+        device->timers.free_queries.push_back(region.queries[0]);
+        device->timers.free_queries.push_back(region.queries[1]);
+    }
+
+    // Names can only be pointed to once the vector stops growing
+    for(size_t i = 0; i < device->timers.results.size(); i++)
+        device->timers.results[i].name = device->timers.names[i].c_str();
+    return true;
+}
+
+static size_t getPrimitiveCount(uint32_t mode, int32_t count)
+{
+    const size_t n = static_cast<size_t>(std::max(count, 0));
+    switch(mode) {
+        case GL_LINES:
+            return n / 2;
+        case GL_LINE_STRIP:
+            return n ? n - 1 : 0;
+        case GL_TRIANGLES:
+            return n / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            return n > 2 ? n - 2 : 0;
+        default:
+            return n;
+    }
+}
+
+static void countCommand(uvre::FrameStats &stats, const uvre::Command &cmd, uint32_t mode)
+{
+    stats.num_commands++;
+    switch(cmd.type) {
+        case uvre::CommandType::BIND_STORAGE_BUFFER:
+            stats.num_binds++;
+            stats.binds.storage_buffers++;
+            break;
+        case uvre::CommandType::BIND_UNIFORM_BUFFER:
+            stats.num_binds++;
+            stats.binds.uniform_buffers++;
+            break;
+        case uvre::CommandType::BIND_INDEX_BUFFER:
+            stats.num_binds++;
+            stats.binds.index_buffers++;
+            break;
+        case uvre::CommandType::BIND_VERTEX_BUFFER:
+            stats.num_binds++;
+            stats.binds.vertex_buffers++;
+            break;
+        case uvre::CommandType::BIND_SAMPLER:
+            stats.num_binds++;
+            stats.binds.samplers++;
+            break;
+        case uvre::CommandType::BIND_TEXTURE:
+            stats.num_binds++;
+            stats.binds.textures++;
+            break;
+        case uvre::CommandType::BIND_GROUP:
+            stats.num_binds++;
+            stats.binds.groups++;
+            break;
+        case uvre::CommandType::CLEAR:
+        case uvre::CommandType::CLEAR_ATTACHMENT:
+            stats.num_clears++;
+            break;
+        case uvre::CommandType::COPY_TEXTURE:
+        case uvre::CommandType::COPY_RENDER_TARGET:
+            stats.num_copies++;
+            break;
+        case uvre::CommandType::WRITE_BUFFER:
+            stats.bytes_written += cmd.buffer_write.size;
+            break;
+        case uvre::CommandType::DRAW:
+            stats.num_draws++;
+            stats.num_instances += static_cast<size_t>(cmd.draw.a.instances);
+            stats.num_primitives += getPrimitiveCount(mode, cmd.draw.a.vertices) * static_cast<size_t>(cmd.draw.a.instances);
+            break;
+        case uvre::CommandType::IDRAW:
+            stats.num_draws++;
+            stats.num_instances += static_cast<size_t>(cmd.draw.e.instances);
+            stats.num_primitives += getPrimitiveCount(mode, cmd.draw.e.indices) * static_cast<size_t>(cmd.draw.e.instances);
+            break;
+        default:
+            break;
+    }
+}
+
+static inline uint32_t getTextureBinding(uint32_t target)
+{
+    switch(target) {
+        case GL_TEXTURE_CUBE_MAP:
+            return GL_TEXTURE_BINDING_CUBE_MAP;
+        case GL_TEXTURE_2D_ARRAY:
+            return GL_TEXTURE_BINDING_2D_ARRAY;
+        default:
+            return GL_TEXTURE_BINDING_2D;
+    }
+}
+
+static double getElapsedTime(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
 {
-    int32_t last_binding;
     uvre::CommandListImpl *glcommands = static_cast<uvre::CommandListImpl *>(commands);
+    const uvre::BindGroup_S *bound_groups[uvre::MAX_BIND_GROUPS] = {};
+    int32_t last_texture;
+    const std::chrono::steady_clock::time_point start = uvre::FRAME_STATS_ENABLED ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point {};
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.num_submits++;
+
     for(size_t i = 0; i < glcommands->num_commands; i++) {
         const uvre::Command &cmd = glcommands->commands[i];
         uvre::VertexArray_S *vaonode = nullptr;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            countCommand(frame_stats, cmd, bound_pipeline.primitive_mode);
         switch(cmd.type) {
             case uvre::CommandType::SET_SCISSOR:
                 glScissor(cmd.scvp.x, cmd.scvp.y, cmd.scvp.w, cmd.scvp.h);
@@ -919,8 +2091,35 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
             case uvre::CommandType::CLEAR:
                 glClear(cmd.clear_mask);
                 break;
+            case uvre::CommandType::BEGIN_RENDER_PASS:
+                // Framebuffer invalidation is a GL 4.3 thing,
+                // so the DONT_CARE load action is just LOAD here.
+                glBindFramebuffer(GL_FRAMEBUFFER, cmd.pass.target);
+                bound_target = cmd.pass.target;
+                break;
+            case uvre::CommandType::CLEAR_ATTACHMENT:
+                // Load actions clear the whole attachment
+                if(bound_pipeline.scissor_test)
+                    glDisable(GL_SCISSOR_TEST);
+                if(cmd.attachment_clear.buffer == GL_COLOR)
+                    glClearBufferfv(GL_COLOR, cmd.attachment_clear.drawbuffer, cmd.attachment_clear.color);
+                else if(cmd.attachment_clear.buffer == GL_DEPTH)
+                    glClearBufferfv(GL_DEPTH, 0, &cmd.attachment_clear.depth);
+                else
+                    glClearBufferiv(GL_STENCIL, 0, &cmd.attachment_clear.stencil);
+                if(bound_pipeline.scissor_test)
+                    glEnable(GL_SCISSOR_TEST);
+                break;
+            case uvre::CommandType::END_RENDER_PASS:
+                // Same thing: STORE and DISCARD are equivalent
+                break;
             case uvre::CommandType::BIND_PIPELINE:
+                // Deduplicated pipelines share their ID
+                if(cmd.pipeline.id == bound_pipeline.id)
+                    break;
                 bound_pipeline = cmd.pipeline;
+                if constexpr(uvre::FRAME_STATS_ENABLED)
+                    frame_stats.num_pipeline_switches++;
                 glDisable(GL_BLEND);
                 glDisable(GL_DEPTH_TEST);
                 glDisable(GL_CULL_FACE);
@@ -945,6 +2144,7 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
                 glUseProgram(bound_pipeline.program);
                 break;
             case uvre::CommandType::BIND_UNIFORM_BUFFER:
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
                 glBindBufferBase(GL_UNIFORM_BUFFER, cmd.bind_index, cmd.object);
                 break;
             case uvre::CommandType::BIND_INDEX_BUFFER: // OPTIMIZE
@@ -955,6 +2155,8 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
                 if(vaonode->vaobj != bound_pipeline.bound_vao) {
                     bound_pipeline.bound_vao = vaonode->vaobj;
                     glBindVertexArray(vaonode->vaobj);
+                    if constexpr(uvre::FRAME_STATS_ENABLED)
+                        frame_stats.num_vao_switches++;
                 }
                 if(vaonode->vbobj != cmd.buffer.bufobj) {
                     vaonode->vbobj = cmd.buffer.bufobj;
@@ -964,25 +2166,45 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
                 }
                 break;
             case uvre::CommandType::BIND_SAMPLER:
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
                 glBindSampler(cmd.bind_index, cmd.object);
                 break;
             case uvre::CommandType::BIND_TEXTURE:
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
                 glActiveTexture(GL_TEXTURE0 + cmd.bind_index);
                 glBindTexture(cmd.tex_target, cmd.object);
                 break;
             case uvre::CommandType::BIND_RENDER_TARGET:
                 glBindFramebuffer(GL_FRAMEBUFFER, cmd.object);
+                bound_target = cmd.object;
+                break;
+            case uvre::CommandType::BIND_GROUP:
+                if(cmd.bind_index < uvre::MAX_BIND_GROUPS && bound_groups[cmd.bind_index] && bound_groups[cmd.bind_index]->id == cmd.group->id)
+                    break;
+                invalidateBindGroups(bound_groups, cmd.group->slots);
+                if(cmd.bind_index < uvre::MAX_BIND_GROUPS)
+                    bound_groups[cmd.bind_index] = cmd.group;
+                applyBindGroup(cmd.group);
                 break;
             case uvre::CommandType::WRITE_BUFFER:
                 glBindBuffer(GL_COPY_READ_BUFFER, cmd.buffer_write.buffer);
                 glBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(cmd.buffer_write.offset), static_cast<GLsizeiptr>(cmd.buffer_write.size), cmd.buffer_write.data_ptr);
                 break;
+            case uvre::CommandType::GENERATE_MIPMAPS:
+                // The active unit belongs to the last bindTexture
+                glGetIntegerv(getTextureBinding(cmd.tex_target), &last_texture);
+                glBindTexture(cmd.tex_target, cmd.object);
+                glGenerateMipmap(cmd.tex_target);
+                glBindTexture(cmd.tex_target, static_cast<uint32_t>(last_texture));
+                break;
+            case uvre::CommandType::COPY_TEXTURE:
+                blitTexture(this, cmd);
+                break;
             case uvre::CommandType::COPY_RENDER_TARGET:
-                glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_binding);
                 glBindFramebuffer(GL_READ_FRAMEBUFFER, cmd.rt_copy.src);
                 glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cmd.rt_copy.dst);
                 glBlitFramebuffer(cmd.rt_copy.sx0, cmd.rt_copy.sy0, cmd.rt_copy.sx1, cmd.rt_copy.sy1, cmd.rt_copy.dx0, cmd.rt_copy.dy0, cmd.rt_copy.dx1, cmd.rt_copy.dy1, cmd.rt_copy.mask, cmd.rt_copy.filter);
-                glBindFramebuffer(GL_FRAMEBUFFER, static_cast<uint32_t>(last_binding));
+                glBindFramebuffer(GL_FRAMEBUFFER, bound_target);
                 break;
             case uvre::CommandType::DRAW:
                 glDrawArraysInstancedBaseInstance(bound_pipeline.primitive_mode, cmd.draw.a.base_vertex, cmd.draw.a.vertices, cmd.draw.a.instances, cmd.draw.a.base_instance);
@@ -990,8 +2212,25 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
             case uvre::CommandType::IDRAW:
                 glDrawElementsInstancedBaseVertexBaseInstance(bound_pipeline.primitive_mode, cmd.draw.e.indices, bound_pipeline.index_type, reinterpret_cast<const void *>(static_cast<uintptr_t>(bound_pipeline.index_size * cmd.draw.e.base_index)), cmd.draw.e.instances, cmd.draw.e.base_vertex, cmd.draw.e.base_instance);
                 break;
+            case uvre::CommandType::BEGIN_TIMER:
+                beginTimer(this, glcommands->names[cmd.object]);
+                break;
+            case uvre::CommandType::END_TIMER:
+                endTimer(this);
+                break;
+            case uvre::CommandType::PUSH_DEBUG_GROUP:
+                if(GLAD_GL_KHR_debug)
+                    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, glcommands->names[cmd.object].c_str());
+                break;
+            case uvre::CommandType::POP_DEBUG_GROUP:
+                if(GLAD_GL_KHR_debug)
+                    glPopDebugGroup();
+                break;
         }
     }
+
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.submit_time += getElapsedTime(start);
 }
 
 void uvre::RenderDeviceImpl::prepare()
@@ -999,11 +2238,53 @@ void uvre::RenderDeviceImpl::prepare()
     // Third-party overlay applications
     // can cause mayhem if this is not called.
     glUseProgram(0);
+
+    // Don't let the CPU run too far ahead, otherwise
+    // the latency depends on how much the driver queues.
+    const auto start = std::chrono::steady_clock::now();
+    while(create_info.max_frames_in_flight > 0 && pacing.fences.size() >= static_cast<size_t>(create_info.max_frames_in_flight)) {
+        GLenum result;
+        do {
+            result = glClientWaitSync(pacing.fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, uvre::FRAME_FENCE_TIMEOUT);
+        } while(result == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(pacing.fences.front());
+        pacing.fences.pop_front();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    pacing.wait_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+    last_frame_stats = frame_stats;
+    frame_stats = uvre::FrameStats {};
+
+    // Release staging memory of finished uploads
+    while(retireUpload(this, 0))
+        continue;
+
+    // Timers left open keep their frame going
+    while(timers.frames.size() > 1 && readTimerFrame(this, timers.frames.front()))
+        timers.frames.pop_front();
+    if(timers.open.empty() && (timers.frames.empty() || !timers.frames.back().regions.empty()))
+        timers.frames.emplace_back();
+
+    // Recycle the transient targets and drop the
+    // ones nobody asked for in a few frames.
+    frame_count++;
+    for(std::vector<uvre::TransientTargetEntry>::iterator it = transient_targets.begin(); it != transient_targets.end();) {
+        it->in_use = false;
+        if(frame_count - it->last_frame > uvre::TRANSIENT_TARGET_LIFETIME) {
+            it = transient_targets.erase(it);
+            continue;
+        }
+        it++;
+    }
 }
 
 void uvre::RenderDeviceImpl::present()
 {
     create_info.gl.swapBuffers(create_info.gl.user_data);
+    if(create_info.max_frames_in_flight > 0)
+        pacing.fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
 }
 
 void uvre::RenderDeviceImpl::vsync(bool enable)
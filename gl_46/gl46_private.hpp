@@ -8,14 +8,67 @@
  */
 #include <uvre/uvre.hpp>
 #include <algorithm>
+#include <chrono>
+#include <deque>
 #include <glad/gl.h>
 #include <limits>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace uvre
 {
+// Statistics cost nothing when they're compiled out
+#if defined(UVRE_FRAME_STATS)
+static constexpr const bool FRAME_STATS_ENABLED = true;
+#else
+static constexpr const bool FRAME_STATS_ENABLED = false;
+#endif
+
+// S3TC is not core, so GLAD doesn't know about it
+static constexpr const uint32_t COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+static constexpr const uint32_t COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+// KHR_parallel_shader_compile, same thing
+using PFNMAXSHADERCOMPILERTHREADSPROC = void(GLAD_API_PTR *)(GLuint count);
+static constexpr const uint32_t COMPLETION_STATUS = 0x91B1;
+
+// ARB_bindless_texture, loaded manually for the same reason
+using PFNGETTEXTUREHANDLEPROC = GLuint64(GLAD_API_PTR *)(GLuint texture);
+using PFNGETTEXTURESAMPLERHANDLEPROC = GLuint64(GLAD_API_PTR *)(GLuint texture, GLuint sampler);
+using PFNMAKETEXTUREHANDLERESIDENTPROC = void(GLAD_API_PTR *)(GLuint64 handle);
+using PFNMAKETEXTUREHANDLENONRESIDENTPROC = void(GLAD_API_PTR *)(GLuint64 handle);
+
+// Fallback bindless pages start this deep and double when full
+static constexpr const int BINDLESS_PAGE_LAYERS = 16;
+
+// Binds to slots below this are batched into multi-bind calls
+static constexpr const uint32_t MAX_BATCHED_BINDINGS = 32;
+
+// Every way of reading a buffer a shader might have written to
+static constexpr const uint32_t BUFFER_BARRIER_BITS = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT;
+
+// Same thing, but for textures written as images
+static constexpr const uint32_t TEXTURE_BARRIER_BITS = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT;
+
+// Frame fences are polled this often (in nanoseconds) while waiting
+static constexpr const uint64_t FRAME_FENCE_TIMEOUT = 1000000000;
+
+// Timestamp queries are created this many at a time
+static constexpr const size_t TIMER_QUERY_BATCH = 32;
+
+// Every stage gets its own precomputed source prologue
+static constexpr const size_t NUM_SHADER_STAGES = 4;
+
+// Unused transient render targets are destroyed after this many frames
+static constexpr const uint64_t TRANSIENT_TARGET_LIFETIME = 8;
+
+// Render pass attachment bits, color attachments use the lower bits
+static constexpr const uint32_t MAX_PASS_COLOR_ATTACHMENTS = 8;
+static constexpr const uint32_t PASS_DEPTH_ATTACHMENT = (1 << 8);
+static constexpr const uint32_t PASS_STENCIL_ATTACHMENT = (1 << 9);
+
 struct VertexArray_S final {
     uint32_t index;
     uint32_t vaobj;
@@ -30,12 +83,33 @@ struct VBOBinding final {
 };
 
 struct Shader_S final {
+    uint64_t id;
+    uint64_t key_hash;
     uint32_t prog;
+    uint32_t shobj;
     uint32_t stage_bit;
     ShaderStage stage;
+    bool pending;
+    uint64_t cache_key;
+    uint32_t storage_mask; // bindings the program declares
+    uint32_t image_mask;
+    std::string debug_name; // the program is made later
+};
+
+// Pipelines made of shaders that are still being
+// compiled attach their stages once they're done.
+struct PendingPipeline final {
+    std::vector<Shader> shaders;
+    Pipeline placeholder;
+    uint32_t storage_mask;
+    uint32_t image_mask;
+    bool ready;
+    bool failed; // a stage didn't compile
 };
 
 struct Pipeline_S final {
+    uint64_t id;
+    uint64_t key_hash;
     uint32_t bound_ibo; // OPTIMIZE
     uint32_t bound_vao; // OPTIMIZE
     uint32_t ppobj;
@@ -63,6 +137,9 @@ struct Pipeline_S final {
     size_t num_attributes;
     VertexAttrib *attributes;
     VertexArray_S *vaos;
+    PendingPipeline *pending;
+    uint32_t storage_mask;
+    uint32_t image_mask;
 };
 
 struct Buffer_S final {
@@ -74,25 +151,121 @@ struct Buffer_S final {
 struct Texture_S final {
     uint32_t texobj;
     uint32_t format;
+    uint32_t target;
     int width;
     int height;
     int depth;
+    int levels;
+};
+
+struct UploadRegion final {
+    UploadTicket ticket;
+    GLsync fence;
+    size_t offset;
+    size_t size;
 };
 
 struct Sampler_S final {
+    uint64_t key_hash;
     uint32_t ssobj;
 };
 
+struct BindGroupRun final {
+    BindingType type;
+    uint32_t first;
+    uint32_t count;
+    size_t offset;
+};
+
+// Entries are kept around so that the resources
+// live at least as long as the group referencing them.
+struct BindGroup_S final {
+    uint64_t id;
+    uint32_t slots;
+    std::vector<BindGroupEntry> entries;
+    std::vector<BindGroupRun> runs;
+    std::vector<uint32_t> objects;
+    std::vector<GLintptr> offsets;
+    std::vector<GLsizeiptr> sizes;
+    std::vector<uint8_t> writable;
+};
+
+// Content-addressed objects are looked up by a hash of their
+// create info, the full key only settles hash collisions.
+template<typename T>
+struct CacheEntry final {
+    std::string key;
+    std::weak_ptr<T> object;
+};
+
 struct RenderTarget_S final {
     uint32_t fbobj;
 };
 
+struct HazardSlot final {
+    uint32_t object;
+    bool writable;
+};
+
+struct BindlessEntry final {
+    Texture texture;
+    Sampler sampler;
+    uint64_t handle;
+    uint32_t page;
+    int layer;
+    bool in_use;
+};
+
+struct BindlessPage final {
+    uint32_t texobj;
+    uint32_t format;
+    Sampler sampler;
+    int width;
+    int height;
+    int levels;
+    int layers;
+    int top;
+    std::vector<int> free_layers;
+};
+
+// Both timestamps are allocated when a timer begins,
+// the end one is only written if the timer is ended.
+struct TimerRegion final {
+    std::string name;
+    uint32_t queries[2];
+    bool ended;
+};
+
+struct TimerFrame final {
+    std::vector<TimerRegion> regions;
+};
+
+struct TransientTargetEntry final {
+    int width;
+    int height;
+    size_t num_color_attachments;
+    PixelFormat color_formats[MAX_COLOR_ATTACHMENTS];
+    bool use_depth;
+    PixelFormat depth_format;
+    bool in_use;
+    uint64_t last_frame;
+    TransientTarget target;
+};
+
+struct BindBatch final {
+    uint32_t mask;
+    uint32_t objects[MAX_BATCHED_BINDINGS];
+};
+
 enum class CommandType {
     SET_SCISSOR,
     SET_VIEWPORT,
     SET_CLEAR_COLOR,
     SET_CLEAR_DEPTH,
     CLEAR,
+    BEGIN_RENDER_PASS,
+    CLEAR_ATTACHMENT,
+    END_RENDER_PASS,
     BIND_PIPELINE,
     BIND_STORAGE_BUFFER,
     BIND_UNIFORM_BUFFER,
@@ -101,10 +274,21 @@ enum class CommandType {
     BIND_SAMPLER,
     BIND_TEXTURE,
     BIND_RENDER_TARGET,
+    BIND_IMAGE,
+    BIND_GROUP,
     WRITE_BUFFER,
+    GENERATE_MIPMAPS,
+    COPY_TEXTURE,
     COPY_RENDER_TARGET,
     DRAW,
-    IDRAW
+    IDRAW,
+    DISPATCH,
+    DISPATCH_INDIRECT,
+    MEMORY_BARRIER,
+    BEGIN_TIMER,
+    END_TIMER,
+    PUSH_DEBUG_GROUP,
+    POP_DEBUG_GROUP
 };
 
 union DrawCmd final {
@@ -134,9 +318,33 @@ struct Command final {
         float color[4];
         float depth;
         uint32_t clear_mask;
+        struct {
+            uint32_t target;
+            uint32_t attachments;
+        } pass;
+        struct {
+            uint32_t target;
+            uint32_t buffer;
+            int32_t drawbuffer;
+            float color[4];
+            float depth;
+            int32_t stencil;
+        } attachment_clear;
         Pipeline_S pipeline;
         Buffer_S buffer;
         uint32_t object;
+        struct {
+            uint32_t bufobj;
+            bool writable;
+        } storage;
+        struct {
+            uint32_t texobj;
+            int32_t level;
+            int32_t layer;
+            uint32_t access;
+            PixelFormat format;
+        } image;
+        const BindGroup_S *group;
         struct {
             uint32_t buffer;
             size_t offset;
@@ -150,7 +358,23 @@ struct Command final {
             uint32_t mask;
             uint32_t filter;
         } rt_copy;
+        struct {
+            uint32_t src, dst;
+            uint32_t src_target, dst_target;
+            int src_level, dst_level;
+            int sx, sy, sz;
+            int dx, dy, dz;
+            int w, h, d;
+        } tex_copy;
         DrawCmd draw;
+        struct {
+            uint32_t x, y, z;
+        } dispatch;
+        struct {
+            uint32_t buffer;
+            size_t offset;
+        } indirect;
+        uint32_t barriers;
     };
 };
 
@@ -167,24 +391,46 @@ public:
     void setClearColor4f(float r, float g, float b, float a) override;
     void clear(RenderTargetMask mask) override;
 
+    void beginRenderPass(const RenderPassInfo &info) override;
+    void endRenderPass() override;
+
     void bindPipeline(Pipeline pipeline) override;
-    void bindStorageBuffer(Buffer buffer, uint32_t index) override;
+    void bindStorageBuffer(Buffer buffer, uint32_t index, bool writable) override;
     void bindUniformBuffer(Buffer buffer, uint32_t index) override;
     void bindIndexBuffer(Buffer buffer) override;
     void bindVertexBuffer(Buffer buffer) override;
     void bindSampler(Sampler sampler, uint32_t index) override;
     void bindTexture(Texture texture, uint32_t index) override;
     void bindRenderTarget(RenderTarget target) override;
+    void bindImage(Texture texture, uint32_t unit, int level, int layer, ImageAccess access, PixelFormat format) override;
+
+    void bindGroup(BindGroup group, uint32_t set) override;
 
     void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) override;
+    void generateMipmaps(Texture texture) override;
+    void copyTexture(Texture src, int src_level, int sx, int sy, int sz, Texture dst, int dst_level, int dx, int dy, int dz, int width, int height, int depth) override;
     void copyRenderTarget(RenderTarget src, RenderTarget dst, int sx0, int sy0, int sx1, int sy1, int dx0, int dy0, int dx1, int dy1, RenderTargetMask mask, bool filter) override;
 
     void draw(size_t vertices, size_t instances, size_t base_vertex, size_t base_instance) override;
     void idraw(size_t indices, size_t instances, size_t base_index, size_t base_vertex, size_t base_instance) override;
 
+    void dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void dispatchIndirect(Buffer buffer, size_t offset) override;
+    void memoryBarrier(BarrierMask mask) override;
+
+    void beginTimer(const char *name) override;
+    void endTimer() override;
+
+    void pushDebugGroup(const char *name) override;
+    void popDebugGroup() override;
+
 public:
     std::vector<Command> commands;
     size_t num_commands;
+    uint32_t pass_target;
+    uint32_t pass_discard;
+    std::vector<std::string> names;
+    std::vector<BindGroup> groups; // commands only keep raw pointers
 };
 
 class RenderDeviceImpl final : public IRenderDevice {
@@ -193,18 +439,39 @@ public:
     virtual ~RenderDeviceImpl();
 
     const DeviceInfo &getInfo() const;
+    const CacheStats &getCacheStats() const override;
+    size_t getNumBarriers() const override;
+    double getFrameWaitTime() const override;
+    const FrameStats &getFrameStats() const override;
+    size_t getNumTimerResults() const override;
+    const TimerResult &getTimerResult(size_t index) const override;
 
     Shader createShader(const ShaderCreateInfo &info) override;
+    Shader createShaderAsync(const ShaderCreateInfo &info) override;
+    ShaderStatus getShaderStatus(Shader shader) override;
     Pipeline createPipeline(const PipelineCreateInfo &info) override;
+    ShaderStatus getPipelineStatus(Pipeline pipeline) override;
     Buffer createBuffer(const BufferCreateInfo &info) override;
     Sampler createSampler(const SamplerCreateInfo &info) override;
     Texture createTexture(const TextureCreateInfo &info) override;
     RenderTarget createRenderTarget(const RenderTargetCreateInfo &info) override;
+    BindGroup createBindGroup(const BindGroupCreateInfo &info) override;
+
+    TransientTarget acquireTransientTarget(const TransientTargetCreateInfo &info) override;
+    void releaseTransientTarget(const TransientTarget &target) override;
 
     void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) override;
-    void writeTexture2D(Texture texture, int x, int y, int w, int h, PixelFormat format, const void *data) override;
-    void writeTextureCube(Texture texture, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
-    void writeTextureArray(Texture texture, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+    void writeTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    void writeTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    void writeTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+
+    UploadTicket uploadTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    UploadTicket uploadTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) override;
+    UploadTicket uploadTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) override;
+    bool isUploadComplete(UploadTicket ticket) override;
+
+    BindlessTexture createBindlessTexture(Texture texture, Sampler sampler) override;
+    void destroyBindlessTexture(BindlessTexture index) override;
 
     ICommandList *createCommandList() override;
     void destroyCommandList(ICommandList *commands) override;
@@ -226,5 +493,65 @@ public:
     std::vector<Pipeline_S *> pipelines;
     std::vector<Buffer_S *> buffers;
     std::vector<CommandListImpl *> commandlists;
+    std::vector<TransientTargetEntry> transient_targets;
+    uint64_t frame_count;
+    FrameStats frame_stats;
+    FrameStats last_frame_stats;
+    uint64_t next_object_id;
+    CacheStats cache_stats;
+    struct {
+        std::unordered_multimap<uint64_t, CacheEntry<Shader_S>> shaders;
+        std::unordered_multimap<uint64_t, CacheEntry<Pipeline_S>> pipelines;
+        std::unordered_multimap<uint64_t, CacheEntry<Sampler_S>> samplers;
+    } object_cache;
+    std::string shader_prologues[NUM_SHADER_STAGES];
+    struct {
+        std::vector<HazardSlot> storage_slots;
+        std::vector<HazardSlot> uniform_slots;
+        std::vector<HazardSlot> image_slots;
+        std::vector<HazardSlot> texture_slots;
+        uint32_t vertex_buffer;
+        std::unordered_map<uint32_t, uint32_t> pending_buffers;
+        std::unordered_map<uint32_t, uint32_t> pending_textures;
+        size_t num_barriers;
+    } hazards;
+    uint64_t program_cache_seed;
+    bool parallel_compile;
+    struct {
+        uint32_t bufobj;
+        uint8_t *mapped;
+        size_t size;
+        size_t head;
+        UploadTicket last_ticket;
+        UploadTicket completed;
+        std::deque<UploadRegion> regions;
+    } upload;
+    struct {
+        std::deque<GLsync> fences;
+        double wait_time;
+    } pacing;
+    struct {
+        std::vector<uint32_t> free_queries;
+        std::deque<TimerFrame> frames;
+        std::vector<size_t> open;
+        std::vector<std::string> names;
+        std::vector<TimerResult> results;
+    } timers;
+    struct {
+        bool enabled;
+        bool native;
+        bool dirty;
+        uint32_t bufobj;
+        int max_layers;
+        PFNGETTEXTUREHANDLEPROC getTextureHandle;
+        PFNGETTEXTURESAMPLERHANDLEPROC getTextureSamplerHandle;
+        PFNMAKETEXTUREHANDLERESIDENTPROC makeResident;
+        PFNMAKETEXTUREHANDLENONRESIDENTPROC makeNonResident;
+        std::vector<BindlessEntry> entries;
+        std::vector<BindlessTexture> free_entries;
+        std::unordered_map<uint64_t, size_t> residency; // handle -> entries
+        std::vector<BindlessPage> pages;
+        std::vector<uint32_t> table;
+    } bindless;
 };
 } // namespace uvre
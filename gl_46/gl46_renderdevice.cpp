@@ -12,8 +12,19 @@
 
 static uvre::VertexArray_S dummy_vao = { 0, 0, 0, nullptr };
 
-static void GLAPIENTRY debugCallback(GLenum, GLenum, GLuint, GLenum severity, GLsizei, const char *message, const void *arg)
+static void setObjectLabel(uint32_t identifier, uint32_t name, const char *label)
 {
+    if(!label || !label[0])
+        return;
+    glObjectLabel(identifier, name, -1, label);
+}
+
+static void GLAPIENTRY debugCallback(GLenum, GLenum type, GLuint, GLenum severity, GLsizei, const char *message, const void *arg)
+{
+    // Debug groups echo themselves back, that's just noise
+    if(type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP)
+        return;
+
     const uvre::RenderDeviceImpl *device = reinterpret_cast<const uvre::RenderDeviceImpl *>(arg);
         if(device && device->create_info.onDebugMessage) {
 
@@ -39,14 +50,33 @@ static void GLAPIENTRY debugCallback(GLenum, GLenum, GLuint, GLenum severity, GL
     }
 }
 
-static void destroyShader(uvre::Shader_S *shader)
+// Runs from the deleters, so the object is already expired
+template<typename T>
+static void eraseCached(std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash)
+{
+    auto range = cache.equal_range(hash);
+    while(range.first != range.second) {
+        if(range.first->second.object.expired()) {
+            range.first = cache.erase(range.first);
+            continue;
+        }
+
+        range.first++;
+    }
+}
+
+static void destroyShader(uvre::Shader_S *shader, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.shaders, shader->key_hash);
+    glDeleteShader(shader->shobj);
     glDeleteProgram(shader->prog);
     delete shader;
 }
 
 static void destroyPipeline(uvre::Pipeline_S *pipeline, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.pipelines, pipeline->key_hash);
+
     // Remove ourselves from the notify list.
     for(std::vector<uvre::Pipeline_S *>::const_iterator it = device->pipelines.cbegin(); it != device->pipelines.cend(); it++) {
         if(*it != pipeline)
@@ -55,6 +85,8 @@ static void destroyPipeline(uvre::Pipeline_S *pipeline, uvre::RenderDeviceImpl *
         break;
     }
 
+    delete pipeline->pending;
+
     // Chain-free the VAO list
     for(uvre::VertexArray_S *node = pipeline->vaos; node;) {
         uvre::VertexArray_S *next = node->next;
@@ -78,18 +110,25 @@ static void destroyBuffer(uvre::Buffer_S *buffer, uvre::RenderDeviceImpl *device
         break;
     }
 
+    // The name might be handed out again
+    device->hazards.pending_buffers.erase(buffer->bufobj);
+
     glDeleteBuffers(1, &buffer->bufobj);
     delete buffer;
 }
 
-static void destroySampler(uvre::Sampler_S *sampler)
+static void destroySampler(uvre::Sampler_S *sampler, uvre::RenderDeviceImpl *device)
 {
+    eraseCached(device->object_cache.samplers, sampler->key_hash);
     glDeleteSamplers(1, &sampler->ssobj);
     delete sampler;
 }
 
-static void destroyTexture(uvre::Texture_S *texture)
+static void destroyTexture(uvre::Texture_S *texture, uvre::RenderDeviceImpl *device)
 {
+    // The name might be handed out again
+    device->hazards.pending_textures.erase(texture->texobj);
+
     glDeleteTextures(1, &texture->texobj);
     delete texture;
 }
@@ -100,8 +139,214 @@ static void destroyRenderTarget(uvre::RenderTarget_S *target)
     delete target;
 }
 
+static bool isExtensionSupported(const char *name)
+{
+    int32_t num_extensions;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for(int32_t i = 0; i < num_extensions; i++) {
+        if(!std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))), name))
+            return true;
+    }
+
+    return false;
+}
+
+static constexpr const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+static constexpr const uint64_t FNV_PRIME = 0x100000001B3;
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+template<typename T>
+static void appendKey(std::string &key, const T &value)
+{
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static std::shared_ptr<T> findCached(const std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash, const std::string &key, size_t &hits, size_t &misses)
+{
+    const auto range = cache.equal_range(hash);
+    for(auto it = range.first; it != range.second; it++) {
+        if(it->second.key != key)
+            continue;
+
+        std::shared_ptr<T> object = it->second.object.lock();
+        if(object) {
+            hits++;
+            return object;
+        }
+    }
+
+    misses++;
+    return nullptr;
+}
+
+template<typename T>
+static void insertCached(std::unordered_multimap<uint64_t, uvre::CacheEntry<T>> &cache, uint64_t hash, const std::string &key, const std::shared_ptr<T> &object)
+{
+    object->key_hash = hash;
+    cache.emplace(hash, uvre::CacheEntry<T> { key, object });
+}
+
+// Sources don't need a terminator when the size is known
+static size_t getCodeSize(const uvre::ShaderCreateInfo &info)
+{
+    if(info.code_size || info.format != uvre::ShaderFormat::SOURCE_GLSL)
+        return info.code_size;
+    return std::strlen(reinterpret_cast<const char *>(info.code));
+}
+
+static const char *getEntryPoint(const uvre::ShaderCreateInfo &info)
+{
+    return info.entry_point ? info.entry_point : "main";
+}
+
+// Keys are built field by field so that struct padding
+// doesn't make identical create infos look different.
+static std::string getShaderKey(const uvre::ShaderCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.stage);
+    appendKey(key, info.format);
+    key.append(reinterpret_cast<const char *>(info.code), getCodeSize(info));
+    key.append(getEntryPoint(info));
+    key.push_back(0);
+    for(size_t i = 0; i < info.num_constants; i++) {
+        appendKey(key, info.constants[i].id);
+        appendKey(key, info.constants[i].value);
+    }
+    return key;
+}
+
+static std::string getPipelineKey(const uvre::PipelineCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.blending.enabled);
+    appendKey(key, info.blending.equation);
+    appendKey(key, info.blending.sfactor);
+    appendKey(key, info.blending.dfactor);
+    appendKey(key, info.depth_testing.enabled);
+    appendKey(key, info.depth_testing.func);
+    appendKey(key, info.face_culling.enabled);
+    appendKey(key, info.face_culling.flags);
+    appendKey(key, info.scissor_test);
+    appendKey(key, info.index_type);
+    appendKey(key, info.primitive_mode);
+    appendKey(key, info.fill_mode);
+    appendKey(key, info.vertex_stride);
+    appendKey(key, info.num_vertex_attribs);
+    for(size_t i = 0; i < info.num_vertex_attribs; i++) {
+        appendKey(key, info.vertex_attribs[i].id);
+        appendKey(key, info.vertex_attribs[i].type);
+        appendKey(key, info.vertex_attribs[i].count);
+        appendKey(key, info.vertex_attribs[i].offset);
+        appendKey(key, info.vertex_attribs[i].normalized);
+    }
+
+    // Object IDs are never reused, unlike GL names or addresses
+    appendKey(key, info.num_shaders);
+    for(size_t i = 0; i < info.num_shaders; i++)
+        appendKey(key, info.shaders[i] ? info.shaders[i]->id : 0);
+    appendKey(key, info.placeholder ? info.placeholder->id : 0);
+    return key;
+}
+
+static std::string getSamplerKey(const uvre::SamplerCreateInfo &info)
+{
+    std::string key;
+    appendKey(key, info.flags);
+    appendKey(key, info.aniso_level);
+    appendKey(key, info.min_lod);
+    appendKey(key, info.max_lod);
+    appendKey(key, info.lod_bias);
+    return key;
+}
+
+static void writeBindlessPrologue(std::stringstream &ss, bool native)
+{
+    ss << "#define _BINDLESS_ 1" << std::endl;
+    if(native)
+        ss << "#extension GL_ARB_bindless_texture : require" << std::endl;
+    ss << "layout(std430, binding = " << uvre::BINDLESS_TABLE_BINDING << ") readonly buffer _uvre_bindless_table {" << std::endl;
+    ss << " uvec2 _uvre_bindless[];" << std::endl;
+    ss << "};" << std::endl;
+
+    if(native) {
+        ss << "#define uvre_texture(index, uv) texture(sampler2D(_uvre_bindless[(index)]), (uv))" << std::endl;
+        return;
+    }
+
+    // Indexing a sampler array needs a dynamically uniform
+    // index, which a per-draw material index usually is.
+    ss << "layout(binding = " << uvre::BINDLESS_PAGE_UNIT << ") uniform sampler2DArray _uvre_bindless_pages[" << uvre::MAX_BINDLESS_PAGES << "];" << std::endl;
+    ss << "#define uvre_texture(index, uv) texture(_uvre_bindless_pages[_uvre_bindless[(index)].x], vec3((uv), float(_uvre_bindless[(index)].y)))" << std::endl;
+}
+
+// Everything prepended to GLSL sources only depends on the
+// stage and the device, so it's built once for every stage.
+static std::string getShaderPrologue(const uvre::RenderDeviceImpl *device, uvre::ShaderStage stage)
+{
+    std::stringstream ss;
+    ss << "#version 460 core" << std::endl;
+    ss << "#define _UVRE_ 1" << std::endl;
+
+    switch(stage) {
+        case uvre::ShaderStage::VERTEX:
+            ss << "#define _VERTEX_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::GEOMETRY:
+            ss << "#define _GEOMETRY_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::FRAGMENT:
+            ss << "#define _FRAGMENT_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::COMPUTE:
+            ss << "#define _COMPUTE_SHADER_ 1" << std::endl;
+            break;
+    }
+
+    ss << "#define _GLSL_ 1" << std::endl;
+    if(device->bindless.enabled)
+        writeBindlessPrologue(ss, device->bindless.native);
+
+    if(stage == uvre::ShaderStage::VERTEX) {
+        // For some unknown reason Khronos decided that
+        // gl_PerVertex needs to be defined manually for
+        // separate programs. I really don't know. Too bad!
+        ss << "out gl_PerVertex {" << std::endl;
+        ss << " vec4 gl_Position;" << std::endl;
+        ss << " float gl_PointSize;" << std::endl;
+        ss << " float gl_ClipDistance[];" << std::endl;
+        ss << "};" << std::endl;
+    }
+    else if(stage == uvre::ShaderStage::GEOMETRY) {
+        // Same story, but for both directions.
+        ss << "in gl_PerVertex {" << std::endl;
+        ss << " vec4 gl_Position;" << std::endl;
+        ss << " float gl_PointSize;" << std::endl;
+        ss << " float gl_ClipDistance[];" << std::endl;
+        ss << "} gl_in[];" << std::endl;
+        ss << "out gl_PerVertex {" << std::endl;
+        ss << " vec4 gl_Position;" << std::endl;
+        ss << " float gl_PointSize;" << std::endl;
+        ss << " float gl_ClipDistance[];" << std::endl;
+        ss << "};" << std::endl;
+    }
+
+    return ss.str();
+}
+
 uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_info)
-    : create_info(create_info), vbos(nullptr), bound_pipeline(), null_pipeline(), pipelines(), buffers(), commandlists()
+    : create_info(create_info), vbos(nullptr), bound_pipeline(), null_pipeline(), pipelines(), buffers(), commandlists(), transient_targets(), frame_count(0), frame_stats(), last_frame_stats(), next_object_id(1), cache_stats(), object_cache(), hazards(), program_cache_seed(0), parallel_compile(false), upload(), pacing(), timers(), bindless()
 {
     glGetIntegerv(GL_MAX_VERTEX_ATTRIB_BINDINGS, &max_vbo_bindings);
 
@@ -111,6 +356,28 @@ uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_in
     info.impl_version_minor = 5;
     info.supports_anisotropic = true;
     info.supports_storage_buffers = true;
+    info.supports_compute = true;
+    info.supports_compression_s3tc = isExtensionSupported("GL_EXT_texture_compression_s3tc");
+    info.supports_compression_rgtc = true;
+    info.supports_compression_bptc = true;
+    info.supports_bindless = isExtensionSupported("GL_ARB_bindless_texture");
+
+    // Binaries are only valid for the exact driver that made them
+    const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    program_cache_seed = hashBytes(FNV_OFFSET_BASIS, renderer, renderer ? std::strlen(renderer) : 0);
+    program_cache_seed = hashBytes(program_cache_seed, version, version ? std::strlen(version) : 0);
+
+    // Let the driver pick the number of compiler threads
+    if(create_info.gl.getProcAddr && (isExtensionSupported("GL_KHR_parallel_shader_compile") || isExtensionSupported("GL_ARB_parallel_shader_compile"))) {
+        uvre::PFNMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = reinterpret_cast<uvre::PFNMAXSHADERCOMPILERTHREADSPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glMaxShaderCompilerThreadsKHR"));
+        if(!maxShaderCompilerThreads)
+            maxShaderCompilerThreads = reinterpret_cast<uvre::PFNMAXSHADERCOMPILERTHREADSPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glMaxShaderCompilerThreadsARB"));
+        if(maxShaderCompilerThreads) {
+            maxShaderCompilerThreads(0xFFFFFFFF);
+            parallel_compile = true;
+        }
+    }
     info.supports_shader_format[static_cast<int>(uvre::ShaderFormat::BINARY_SPIRV)] = true;
     info.supports_shader_format[static_cast<int>(uvre::ShaderFormat::SOURCE_GLSL)] = true;
 
@@ -136,6 +403,36 @@ uvre::RenderDeviceImpl::RenderDeviceImpl(const uvre::DeviceCreateInfo &create_in
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
         glDebugMessageCallback(debugCallback, this);
     }
+
+    if(create_info.upload_buffer_size) {
+        const uint32_t flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        upload.size = create_info.upload_buffer_size;
+        glCreateBuffers(1, &upload.bufobj);
+        glNamedBufferStorage(upload.bufobj, static_cast<GLsizeiptr>(upload.size), nullptr, flags);
+        upload.mapped = reinterpret_cast<uint8_t *>(glMapNamedBufferRange(upload.bufobj, 0, static_cast<GLsizeiptr>(upload.size), flags));
+    }
+
+    if(create_info.use_bindless) {
+        if(info.supports_bindless && create_info.gl.getProcAddr) {
+            bindless.getTextureHandle = reinterpret_cast<uvre::PFNGETTEXTUREHANDLEPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glGetTextureHandleARB"));
+            bindless.getTextureSamplerHandle = reinterpret_cast<uvre::PFNGETTEXTURESAMPLERHANDLEPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glGetTextureSamplerHandleARB"));
+            bindless.makeResident = reinterpret_cast<uvre::PFNMAKETEXTUREHANDLERESIDENTPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glMakeTextureHandleResidentARB"));
+            bindless.makeNonResident = reinterpret_cast<uvre::PFNMAKETEXTUREHANDLENONRESIDENTPROC>(create_info.gl.getProcAddr(create_info.gl.user_data, "glMakeTextureHandleNonResidentARB"));
+            bindless.native = bindless.getTextureHandle && bindless.getTextureSamplerHandle && bindless.makeResident && bindless.makeNonResident;
+        }
+
+        // Index zero is never handed out so that
+        // it can be used as an error value.
+        bindless.enabled = true;
+        bindless.dirty = true;
+        bindless.entries.resize(1);
+        bindless.table.resize(2, 0);
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &bindless.max_layers);
+        glCreateBuffers(1, &bindless.bufobj);
+    }
+
+    for(size_t i = 0; i < uvre::NUM_SHADER_STAGES; i++)
+        shader_prologues[i] = getShaderPrologue(this, static_cast<uvre::ShaderStage>(i));
 }
 
 uvre::RenderDeviceImpl::~RenderDeviceImpl()
@@ -146,6 +443,44 @@ uvre::RenderDeviceImpl::~RenderDeviceImpl()
     pipelines.clear();
     buffers.clear();
     commandlists.clear();
+    transient_targets.clear();
+
+    for(const uvre::UploadRegion &region : upload.regions)
+        glDeleteSync(region.fence);
+    upload.regions.clear();
+
+    for(GLsync fence : pacing.fences)
+        glDeleteSync(fence);
+    pacing.fences.clear();
+
+    for(const uvre::TimerFrame &frame : timers.frames) {
+        for(const uvre::TimerRegion &region : frame.regions)
+            glDeleteQueries(2, region.queries);
+    }
+
+    if(!timers.free_queries.empty())
+        glDeleteQueries(static_cast<GLsizei>(timers.free_queries.size()), timers.free_queries.data());
+    timers.frames.clear();
+    timers.free_queries.clear();
+
+    if(upload.bufobj) {
+        glUnmapNamedBuffer(upload.bufobj);
+        glDeleteBuffers(1, &upload.bufobj);
+    }
+
+    // Entries can share a handle, it's only resident once
+    for(const auto &it : bindless.residency)
+        bindless.makeNonResident(it.first);
+    bindless.residency.clear();
+    bindless.free_entries.clear();
+
+    for(const uvre::BindlessPage &page : bindless.pages)
+        glDeleteTextures(1, &page.texobj);
+    bindless.entries.clear();
+    bindless.pages.clear();
+
+    if(bindless.bufobj)
+        glDeleteBuffers(1, &bindless.bufobj);
 
     // Make sure that the GL context doesn't use it anymore
     glDisable(GL_DEBUG_OUTPUT);
@@ -157,11 +492,138 @@ const uvre::DeviceInfo &uvre::RenderDeviceImpl::getInfo() const
     return info;
 }
 
-uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &info)
+const uvre::CacheStats &uvre::RenderDeviceImpl::getCacheStats() const
 {
-    std::stringstream ss;
-    ss << "#version 460 core" << std::endl;
-    ss << "#define _UVRE_ 1" << std::endl;
+    return cache_stats;
+}
+
+double uvre::RenderDeviceImpl::getFrameWaitTime() const
+{
+    return pacing.wait_time;
+}
+
+const uvre::FrameStats &uvre::RenderDeviceImpl::getFrameStats() const
+{
+    return last_frame_stats;
+}
+
+size_t uvre::RenderDeviceImpl::getNumTimerResults() const
+{
+    return timers.results.size();
+}
+
+const uvre::TimerResult &uvre::RenderDeviceImpl::getTimerResult(size_t index) const
+{
+    return timers.results[index];
+}
+
+size_t uvre::RenderDeviceImpl::getNumBarriers() const
+{
+    return hazards.num_barriers;
+}
+
+static uint32_t loadProgramBinary(const uvre::RenderDeviceImpl *device, uint64_t key)
+{
+    const auto &cache = device->create_info.program_cache;
+    if(!cache.load)
+        return 0;
+
+    const size_t size = cache.load(cache.user_data, key, nullptr, 0);
+    if(size <= sizeof(uint32_t))
+        return 0;
+
+    std::vector<uint8_t> data(size);
+    if(cache.load(cache.user_data, key, data.data(), data.size()) != size)
+        return 0;
+
+    // The binary format comes first
+    uint32_t format;
+    std::memcpy(&format, data.data(), sizeof(uint32_t));
+
+    uint32_t prog = glCreateProgram();
+    glProgramParameteri(prog, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(prog, format, data.data() + sizeof(uint32_t), static_cast<GLsizei>(size - sizeof(uint32_t)));
+
+    // Drivers reject binaries they don't like
+    // anymore, in which case we just recompile.
+    int32_t status;
+    glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if(!status) {
+        glDeleteProgram(prog);
+        return 0;
+    }
+
+    return prog;
+}
+
+static void storeProgramBinary(const uvre::RenderDeviceImpl *device, uint32_t prog, uint64_t key)
+{
+    int32_t length;
+    glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return;
+
+    uint32_t format;
+    std::vector<uint8_t> data(sizeof(uint32_t) + static_cast<size_t>(length));
+    glGetProgramBinary(prog, length, nullptr, &format, data.data() + sizeof(uint32_t));
+    std::memcpy(data.data(), &format, sizeof(uint32_t));
+
+    const auto &cache = device->create_info.program_cache;
+    cache.store(cache.user_data, key, data.data(), data.size());
+}
+
+static inline uint32_t getSlotBit(uint32_t index)
+{
+    // Everything past the mask shares the last bit
+    return 1U << std::min<uint32_t>(index, 31);
+}
+
+// Only the bindings a program declares can be written by it,
+// so storage buffers and images bound as writable elsewhere
+// don't count as written by every draw and dispatch after.
+static void getBindingMasks(uvre::Shader_S *shader)
+{
+    int32_t count = 0;
+    shader->storage_mask = 0;
+    shader->image_mask = 0;
+
+    glGetProgramInterfaceiv(shader->prog, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &count);
+    for(int32_t i = 0; i < count; i++) {
+        const uint32_t property = GL_BUFFER_BINDING;
+        int32_t binding = 0;
+        glGetProgramResourceiv(shader->prog, GL_SHADER_STORAGE_BLOCK, static_cast<uint32_t>(i), 1, &property, 1, nullptr, &binding);
+        shader->storage_mask |= getSlotBit(static_cast<uint32_t>(binding));
+    }
+
+    glGetProgramInterfaceiv(shader->prog, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    for(int32_t i = 0; i < count; i++) {
+        const uint32_t properties[3] = { GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE };
+        int32_t values[3] = {};
+        glGetProgramResourceiv(shader->prog, GL_UNIFORM, static_cast<uint32_t>(i), 3, properties, 3, nullptr, values);
+        if(values[0] < GL_IMAGE_1D || values[0] > GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY)
+            continue;
+
+        // SPIR-V images don't have to have a location,
+        // there's no way to know their units then.
+        if(values[1] < 0) {
+            shader->image_mask = ~0U;
+            continue;
+        }
+
+        int32_t unit = 0;
+        glGetUniformiv(shader->prog, values[1], &unit);
+        for(int32_t j = 0; j < std::max(values[2], 1); j++)
+            shader->image_mask |= getSlotBit(static_cast<uint32_t>(unit + j));
+    }
+}
+
+uvre::Shader uvre::RenderDeviceImpl::createShaderAsync(const uvre::ShaderCreateInfo &info)
+{
+    const std::string key = getShaderKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Shader cached = findCached(object_cache.shaders, key_hash, key, cache_stats.shader_hits, cache_stats.shader_misses);
+    if(cached)
+        return cached;
 
     uint32_t stage = 0;
     uint32_t stage_bit = 0;
@@ -169,41 +631,61 @@ uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &
         case uvre::ShaderStage::VERTEX:
             stage = GL_VERTEX_SHADER;
             stage_bit = GL_VERTEX_SHADER_BIT;
-            ss << "#define _VERTEX_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::GEOMETRY:
+            stage = GL_GEOMETRY_SHADER;
+            stage_bit = GL_GEOMETRY_SHADER_BIT;
             break;
         case uvre::ShaderStage::FRAGMENT:
             stage = GL_FRAGMENT_SHADER;
             stage_bit = GL_FRAGMENT_SHADER_BIT;
-            ss << "#define _FRAGMENT_SHADER_ 1" << std::endl;
+            break;
+        case uvre::ShaderStage::COMPUTE:
+            stage = GL_COMPUTE_SHADER;
+            stage_bit = GL_COMPUTE_SHADER_BIT;
             break;
     }
 
-    int32_t status, info_log_length;
-    std::string info_log;
     uint32_t shobj = glCreateShader(stage);
-    const char *source_cstr;
-    std::string source;
+    setObjectLabel(GL_SHADER, shobj, info.debug_name);
+    const char *sources[2];
+    int32_t lengths[2];
+    std::vector<uint32_t> constant_ids;
+    std::vector<uint32_t> constant_values;
+
+    uint32_t prog = 0;
+    uint64_t cache_key = hashBytes(program_cache_seed, &info.stage, sizeof(info.stage));
 
     switch(info.format) {
         case uvre::ShaderFormat::BINARY_SPIRV:
+            for(size_t i = 0; i < info.num_constants; i++) {
+                constant_ids.push_back(info.constants[i].id);
+                constant_values.push_back(info.constants[i].value);
+            }
+
+            // Every specialization is a different program
+            cache_key = hashBytes(cache_key, info.code, info.code_size);
+            cache_key = hashBytes(cache_key, getEntryPoint(info), std::strlen(getEntryPoint(info)) + 1);
+            cache_key = hashBytes(cache_key, constant_ids.data(), constant_ids.size() * sizeof(uint32_t));
+            cache_key = hashBytes(cache_key, constant_values.data(), constant_values.size() * sizeof(uint32_t));
+            if((prog = loadProgramBinary(this, cache_key)) != 0)
+                break;
+
             glShaderBinary(1, &shobj, GL_SHADER_BINARY_FORMAT_SPIR_V, info.code, static_cast<GLsizei>(info.code_size));
-            glSpecializeShader(shobj, "main", 0, nullptr, nullptr);
+            glSpecializeShader(shobj, getEntryPoint(info), static_cast<GLuint>(info.num_constants), constant_ids.data(), constant_values.data());
             break;
         case uvre::ShaderFormat::SOURCE_GLSL:
-            ss << "#define _GLSL_ 1" << std::endl;
-            if(info.stage == uvre::ShaderStage::VERTEX) {
-                // For some unknown reason Khronos decided that
-                // gl_PerVertex needs to be defined manually for
-                // separate programs. I really don't know. Too bad!
-                ss << "out gl_PerVertex {" << std::endl;
-                ss << " vec4 gl_Position;" << std::endl;
-                ss << " float gl_PointSize;" << std::endl;
-                ss << " float gl_ClipDistance[];" << std::endl;
-                ss << "};" << std::endl;
-            }
-            source = ss.str() + reinterpret_cast<const char *>(info.code);
-            source_cstr = source.c_str();
-            glShaderSource(shobj, 1, &source_cstr, nullptr);
+            // The prologue and the user's code go in as
+            // separate strings so that nothing is copied.
+            sources[0] = shader_prologues[static_cast<size_t>(info.stage)].c_str();
+            sources[1] = reinterpret_cast<const char *>(info.code);
+            lengths[0] = static_cast<int32_t>(shader_prologues[static_cast<size_t>(info.stage)].size());
+            lengths[1] = static_cast<int32_t>(getCodeSize(info));
+            cache_key = hashBytes(cache_key, sources[0], static_cast<size_t>(lengths[0]));
+            cache_key = hashBytes(cache_key, sources[1], static_cast<size_t>(lengths[1]));
+            if((prog = loadProgramBinary(this, cache_key)) != 0)
+                break;
+            glShaderSource(shobj, 2, sources, lengths);
             glCompileShader(shobj);
             break;
         default:
@@ -211,58 +693,133 @@ uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &
             return nullptr;
     }
 
-    if(create_info.onDebugMessage) {
-        glGetShaderiv(shobj, GL_INFO_LOG_LENGTH, &info_log_length);
-        if(info_log_length > 1) {
-            info_log.resize(info_log_length);
-            glGetShaderInfoLog(shobj, static_cast<GLsizei>(info_log.size()), nullptr, &info_log[0]);
+    uvre::Shader shader(new uvre::Shader_S, std::bind(destroyShader, std::placeholders::_1, this));
+    shader->id = next_object_id++;
+    shader->prog = prog;
+    shader->shobj = shobj;
+    shader->stage = info.stage;
+    shader->stage_bit = stage_bit;
+    shader->pending = true;
+    shader->cache_key = cache_key;
+    shader->storage_mask = 0;
+    shader->image_mask = 0;
+    shader->debug_name = info.debug_name ? info.debug_name : "";
+
+    // Loaded from the program cache
+    if(prog) {
+        setObjectLabel(GL_PROGRAM, prog, info.debug_name);
+        getBindingMasks(shader.get());
+        glDeleteShader(shobj);
+        shader->shobj = 0;
+        shader->pending = false;
+    }
 
-            uvre::DebugMessageInfo msg = {};
-            msg.level = uvre::DebugMessageLevel::INFO;
-            msg.text = info_log.c_str();
-            create_info.onDebugMessage(msg);
+    insertCached(object_cache.shaders, key_hash, key, shader);
+    return shader;
+}
+
+static bool finishShader(uvre::RenderDeviceImpl *device, uvre::Shader_S *shader, bool wait)
+{
+    int32_t status, info_log_length;
+    std::string info_log;
+
+    if(!shader->pending)
+        return true;
+
+    if(shader->shobj) {
+        // Without parallel compilation there's no way to
+        // ask, the status query just blocks until it's done.
+        if(!wait && device->parallel_compile) {
+            glGetShaderiv(shader->shobj, uvre::COMPLETION_STATUS, &status);
+            if(!status)
+                return false;
         }
-    }
 
-    glGetShaderiv(shobj, GL_COMPILE_STATUS, &status);
-    if(!status) {
-        glDeleteShader(shobj);
-        return nullptr;
+        if(device->create_info.onDebugMessage) {
+            glGetShaderiv(shader->shobj, GL_INFO_LOG_LENGTH, &info_log_length);
+            if(info_log_length > 1) {
+                info_log.resize(info_log_length);
+                glGetShaderInfoLog(shader->shobj, static_cast<GLsizei>(info_log.size()), nullptr, &info_log[0]);
+
+                uvre::DebugMessageInfo msg = {};
+                msg.level = uvre::DebugMessageLevel::INFO;
+                msg.text = info_log.c_str();
+                device->create_info.onDebugMessage(msg);
+            }
+        }
+
+        glGetShaderiv(shader->shobj, GL_COMPILE_STATUS, &status);
+        if(!status) {
+            glDeleteShader(shader->shobj);
+            shader->shobj = 0;
+            shader->pending = false;
+            return true;
+        }
+
+        shader->prog = glCreateProgram();
+        setObjectLabel(GL_PROGRAM, shader->prog, shader->debug_name.c_str());
+        glProgramParameteri(shader->prog, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        if(device->create_info.program_cache.store)
+            glProgramParameteri(shader->prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(shader->prog, shader->shobj);
+        glLinkProgram(shader->prog);
+        glDeleteShader(shader->shobj);
+        shader->shobj = 0;
     }
 
-    uint32_t prog = glCreateProgram();
-    glProgramParameteri(prog, GL_PROGRAM_SEPARABLE, GL_TRUE);
-    glAttachShader(prog, shobj);
-    glLinkProgram(prog);
-    glDeleteShader(shobj);
+    if(!wait && device->parallel_compile) {
+        glGetProgramiv(shader->prog, uvre::COMPLETION_STATUS, &status);
+        if(!status)
+            return false;
+    }
 
-    if(create_info.onDebugMessage) {
-        glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &info_log_length);
+    if(device->create_info.onDebugMessage) {
+        glGetProgramiv(shader->prog, GL_INFO_LOG_LENGTH, &info_log_length);
         if(info_log_length > 1) {
             info_log.resize(info_log_length);
-            glGetProgramInfoLog(prog, static_cast<GLsizei>(info_log.size()), nullptr, &info_log[0]);
+            glGetProgramInfoLog(shader->prog, static_cast<GLsizei>(info_log.size()), nullptr, &info_log[0]);
 
             uvre::DebugMessageInfo msg = {};
             msg.level = uvre::DebugMessageLevel::INFO;
             msg.text = info_log.c_str();
-            create_info.onDebugMessage(msg);
+            device->create_info.onDebugMessage(msg);
         }
     }
 
-    glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    glGetProgramiv(shader->prog, GL_LINK_STATUS, &status);
     if(!status) {
-        glDeleteProgram(prog);
-        return nullptr;
+        glDeleteProgram(shader->prog);
+        shader->prog = 0;
+    }
+    else {
+        getBindingMasks(shader);
+        if(device->create_info.program_cache.store)
+            storeProgramBinary(device, shader->prog, shader->cache_key);
     }
 
-    uvre::Shader shader(new uvre::Shader_S, destroyShader);
-    shader->prog = prog;
-    shader->stage = info.stage;
-    shader->stage_bit = stage_bit;
+    shader->pending = false;
+    return true;
+}
 
+uvre::Shader uvre::RenderDeviceImpl::createShader(const uvre::ShaderCreateInfo &info)
+{
+    uvre::Shader shader = createShaderAsync(info);
+    if(shader)
+        finishShader(this, shader.get(), true);
+    if(!shader || !shader->prog)
+        return nullptr;
     return shader;
 }
 
+uvre::ShaderStatus uvre::RenderDeviceImpl::getShaderStatus(uvre::Shader shader)
+{
+    if(!shader)
+        return uvre::ShaderStatus::FAILED;
+    if(!finishShader(this, shader.get(), false))
+        return uvre::ShaderStatus::PENDING;
+    return shader->prog ? uvre::ShaderStatus::READY : uvre::ShaderStatus::FAILED;
+}
+
 static inline uint32_t getBlendEquation(uvre::BlendEquation equation)
 {
     switch(equation) {
@@ -458,9 +1015,17 @@ static inline uvre::VertexArray_S *getVertexArray(uvre::VertexArray_S **head, ui
 
 uvre::Pipeline uvre::RenderDeviceImpl::createPipeline(const uvre::PipelineCreateInfo &info)
 {
+    const std::string key = getPipelineKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Pipeline cached = findCached(object_cache.pipelines, key_hash, key, cache_stats.pipeline_hits, cache_stats.pipeline_misses);
+    if(cached)
+        return cached;
+
     uvre::Pipeline pipeline(new uvre::Pipeline_S, std::bind(destroyPipeline, std::placeholders::_1, this));
+    pipeline->id = next_object_id++;
 
     glCreateProgramPipelines(1, &pipeline->ppobj);
+    setObjectLabel(GL_PROGRAM_PIPELINE, pipeline->ppobj, info.debug_name);
 
     pipeline->bound_ibo = 0;
     pipeline->bound_vao = 0;
@@ -488,11 +1053,32 @@ uvre::Pipeline uvre::RenderDeviceImpl::createPipeline(const uvre::PipelineCreate
     pipeline->vaos->next = nullptr;
     setVertexFormat(pipeline->vaos, pipeline.get());
 
+    pipeline->pending = nullptr;
+    pipeline->storage_mask = 0;
+    pipeline->image_mask = 0;
     for(size_t i = 0; i < info.num_shaders; i++) {
-        if(info.shaders[i]) {
-            // Use this shader stage
-            glUseProgramStages(pipeline->ppobj, info.shaders[i]->stage_bit, info.shaders[i]->prog);
+        if(!info.shaders[i])
+            continue;
+
+        if(info.shaders[i]->pending) {
+            // Attached later, see resolvePipeline
+            if(!pipeline->pending) {
+                pipeline->pending = new uvre::PendingPipeline;
+                pipeline->pending->placeholder = info.placeholder;
+                pipeline->pending->storage_mask = 0;
+                pipeline->pending->image_mask = 0;
+                pipeline->pending->ready = false;
+                pipeline->pending->failed = false;
+            }
+
+            pipeline->pending->shaders.push_back(info.shaders[i]);
+            continue;
         }
+
+        // Use this shader stage
+        glUseProgramStages(pipeline->ppobj, info.shaders[i]->stage_bit, info.shaders[i]->prog);
+        pipeline->storage_mask |= info.shaders[i]->storage_mask;
+        pipeline->image_mask |= info.shaders[i]->image_mask;
     }
 
     // Notify the buffers
@@ -503,10 +1089,31 @@ uvre::Pipeline uvre::RenderDeviceImpl::createPipeline(const uvre::PipelineCreate
 
     // Add ourselves to the notify list.
     pipelines.push_back(pipeline.get());
+    insertCached(object_cache.pipelines, key_hash, key, pipeline);
 
     return pipeline;
 }
 
+uvre::ShaderStatus uvre::RenderDeviceImpl::getPipelineStatus(uvre::Pipeline pipeline)
+{
+    if(!pipeline || (pipeline->pending && pipeline->pending->failed))
+        return uvre::ShaderStatus::FAILED;
+    if(!pipeline->pending || pipeline->pending->ready)
+        return uvre::ShaderStatus::READY;
+
+    for(const uvre::Shader &shader : pipeline->pending->shaders) {
+        if(!finishShader(this, shader.get(), false))
+            return uvre::ShaderStatus::PENDING;
+    }
+
+    for(const uvre::Shader &shader : pipeline->pending->shaders) {
+        if(!shader->prog)
+            return uvre::ShaderStatus::FAILED;
+    }
+
+    return uvre::ShaderStatus::READY;
+}
+
 static uvre::VBOBinding *getFreeVBOBinding(uvre::VBOBinding **head)
 {
     for(uvre::VBOBinding *node = *head; node; node = node->next) {
@@ -528,6 +1135,7 @@ uvre::Buffer uvre::RenderDeviceImpl::createBuffer(const uvre::BufferCreateInfo &
     uvre::Buffer buffer(new uvre::Buffer_S, std::bind(destroyBuffer, std::placeholders::_1, this));
 
     glCreateBuffers(1, &buffer->bufobj);
+    setObjectLabel(GL_BUFFER, buffer->bufobj, info.debug_name);
 
     buffer->size = info.size;
     buffer->vbo = nullptr;
@@ -550,30 +1158,154 @@ uvre::Buffer uvre::RenderDeviceImpl::createBuffer(const uvre::BufferCreateInfo &
     return buffer;
 }
 
-void uvre::RenderDeviceImpl::writeBuffer(uvre::Buffer buffer, size_t offset, size_t size, const void *data)
+static void clearPendingBits(std::unordered_map<uint32_t, uint32_t> &pending, uint32_t bits)
 {
-    if(offset + size > buffer->size)
-        return;
-    glNamedBufferSubData(buffer->bufobj, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+    for(auto it = pending.begin(); it != pending.end();) {
+        it->second &= ~bits;
+        if(!it->second) {
+            it = pending.erase(it);
+            continue;
+        }
+
+        it++;
+    }
 }
 
-uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInfo &info)
+// Objects written by shaders remember the barrier bits
+// that haven't been issued since; a barrier makes the
+// writes visible to every object for the bits it has.
+static void issueBarrier(uvre::RenderDeviceImpl *device, uint32_t bits)
 {
-    uint32_t ssobj;
-    glCreateSamplers(1, &ssobj);
+    if(!bits)
+        return;
 
-    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_S, (info.flags & SAMPLER_CLAMP_S) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_T, (info.flags & SAMPLER_CLAMP_T) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_R, (info.flags & SAMPLER_CLAMP_R) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glMemoryBarrier(bits);
+    device->hazards.num_barriers++;
 
-    if(info.flags & SAMPLER_FILTER) {
+    clearPendingBits(device->hazards.pending_buffers, bits);
+    clearPendingBits(device->hazards.pending_textures, bits);
+}
+
+static uint32_t getPendingBits(const std::unordered_map<uint32_t, uint32_t> &pending, uint32_t object, uint32_t bits)
+{
+    std::unordered_map<uint32_t, uint32_t>::const_iterator it = pending.find(object);
+    if(it == pending.cend())
+        return 0;
+    return it->second & bits;
+}
+
+static uint32_t getAnyPendingBits(const std::unordered_map<uint32_t, uint32_t> &pending, uint32_t bits)
+{
+    uint32_t result = 0;
+    for(const auto &it : pending)
+        result |= it.second & bits;
+    return result;
+}
+
+static void setHazardSlot(std::vector<uvre::HazardSlot> &slots, uint32_t index, uint32_t object, bool writable)
+{
+    if(index >= slots.size())
+        slots.resize(index + 1, uvre::HazardSlot {});
+    slots[index] = uvre::HazardSlot { object, writable };
+}
+
+static void trackBindGroup(uvre::RenderDeviceImpl *device, const uvre::BindGroup_S *group)
+{
+    for(const uvre::BindGroupRun &run : group->runs) {
+        for(uint32_t i = 0; i < run.count; i++) {
+            const uint32_t object = group->objects[run.offset + i];
+            switch(run.type) {
+                case uvre::BindingType::UNIFORM_BUFFER:
+                    setHazardSlot(device->hazards.uniform_slots, run.first + i, object, false);
+                    break;
+                case uvre::BindingType::STORAGE_BUFFER:
+                    setHazardSlot(device->hazards.storage_slots, run.first + i, object, group->writable[run.offset + i]);
+                    break;
+                case uvre::BindingType::TEXTURE:
+                    setHazardSlot(device->hazards.texture_slots, run.first + i, object, false);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Only the bits that something about to read a
+// written object actually needs are issued.
+static void resolveHazards(uvre::RenderDeviceImpl *device, bool draw, uint32_t ibo, uint32_t indirect)
+{
+    const auto &buffers = device->hazards.pending_buffers;
+    const auto &textures = device->hazards.pending_textures;
+    if(buffers.empty() && textures.empty())
+        return;
+
+    uint32_t bits = 0;
+    for(const uvre::HazardSlot &slot : device->hazards.storage_slots)
+        bits |= getPendingBits(buffers, slot.object, GL_SHADER_STORAGE_BARRIER_BIT);
+    for(const uvre::HazardSlot &slot : device->hazards.uniform_slots)
+        bits |= getPendingBits(buffers, slot.object, GL_UNIFORM_BARRIER_BIT);
+    for(const uvre::HazardSlot &slot : device->hazards.image_slots)
+        bits |= getPendingBits(textures, slot.object, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    for(const uvre::HazardSlot &slot : device->hazards.texture_slots)
+        bits |= getPendingBits(textures, slot.object, GL_TEXTURE_FETCH_BARRIER_BIT);
+    if(draw) {
+        bits |= getPendingBits(buffers, device->hazards.vertex_buffer, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        bits |= getPendingBits(buffers, ibo, GL_ELEMENT_ARRAY_BARRIER_BIT);
+    }
+
+    bits |= getPendingBits(buffers, indirect, GL_COMMAND_BARRIER_BIT);
+    issueBarrier(device, bits);
+}
+
+static void markWritten(uvre::RenderDeviceImpl *device)
+{
+    const auto &storage_slots = device->hazards.storage_slots;
+    for(size_t i = 0; i < storage_slots.size(); i++) {
+        if(storage_slots[i].object && storage_slots[i].writable && (device->bound_pipeline.storage_mask & getSlotBit(static_cast<uint32_t>(i))))
+            device->hazards.pending_buffers[storage_slots[i].object] = uvre::BUFFER_BARRIER_BITS;
+    }
+
+    const auto &image_slots = device->hazards.image_slots;
+    for(size_t i = 0; i < image_slots.size(); i++) {
+        if(image_slots[i].object && image_slots[i].writable && (device->bound_pipeline.image_mask & getSlotBit(static_cast<uint32_t>(i))))
+            device->hazards.pending_textures[image_slots[i].object] = uvre::TEXTURE_BARRIER_BITS;
+    }
+}
+
+void uvre::RenderDeviceImpl::writeBuffer(uvre::Buffer buffer, size_t offset, size_t size, const void *data)
+{
+    if(offset + size > buffer->size)
+        return;
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += size;
+    issueBarrier(this, getPendingBits(hazards.pending_buffers, buffer->bufobj, GL_BUFFER_UPDATE_BARRIER_BIT));
+    glNamedBufferSubData(buffer->bufobj, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInfo &info)
+{
+    const std::string key = getSamplerKey(info);
+    const uint64_t key_hash = hashBytes(FNV_OFFSET_BASIS, key.data(), key.size());
+    uvre::Sampler cached = findCached(object_cache.samplers, key_hash, key, cache_stats.sampler_hits, cache_stats.sampler_misses);
+    if(cached)
+        return cached;
+
+    uint32_t ssobj;
+    glCreateSamplers(1, &ssobj);
+
+    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_S, (info.flags & SAMPLER_CLAMP_S) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_T, (info.flags & SAMPLER_CLAMP_T) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glSamplerParameteri(ssobj, GL_TEXTURE_WRAP_R, (info.flags & SAMPLER_CLAMP_R) ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+
+    if(info.flags & SAMPLER_FILTER) {
         if(info.flags & SAMPLER_FILTER_ANISO)
             glSamplerParameterf(ssobj, GL_TEXTURE_MAX_ANISOTROPY, info.aniso_level);
-        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, (info.flags & SAMPLER_MIPMAP) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         glSamplerParameterf(ssobj, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
     else {
-        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameterf(ssobj, GL_TEXTURE_MIN_FILTER, (info.flags & SAMPLER_MIPMAP) ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
         glSamplerParameterf(ssobj, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
 
@@ -581,8 +1313,10 @@ uvre::Sampler uvre::RenderDeviceImpl::createSampler(const uvre::SamplerCreateInf
     glSamplerParameterf(ssobj, GL_TEXTURE_MAX_LOD, info.max_lod);
     glSamplerParameterf(ssobj, GL_TEXTURE_LOD_BIAS, info.lod_bias);
 
-    uvre::Sampler sampler(new uvre::Sampler_S, destroySampler);
+    uvre::Sampler sampler(new uvre::Sampler_S, std::bind(destroySampler, std::placeholders::_1, this));
     sampler->ssobj = ssobj;
+    insertCached(object_cache.samplers, key_hash, key, sampler);
+    setObjectLabel(GL_SAMPLER, ssobj, info.debug_name);
 
     return sampler;
 }
@@ -676,40 +1410,154 @@ static inline uint32_t getInternalFormat(uvre::PixelFormat format)
             return GL_DEPTH_COMPONENT32F;
         case uvre::PixelFormat::S8_UINT:
             return GL_STENCIL_INDEX8;
+        case uvre::PixelFormat::BC1_UNORM:
+            return uvre::COMPRESSED_RGBA_S3TC_DXT1;
+        case uvre::PixelFormat::BC3_UNORM:
+            return uvre::COMPRESSED_RGBA_S3TC_DXT5;
+        case uvre::PixelFormat::BC4_UNORM:
+            return GL_COMPRESSED_RED_RGTC1;
+        case uvre::PixelFormat::BC4_SNORM:
+            return GL_COMPRESSED_SIGNED_RED_RGTC1;
+        case uvre::PixelFormat::BC5_UNORM:
+            return GL_COMPRESSED_RG_RGTC2;
+        case uvre::PixelFormat::BC5_SNORM:
+            return GL_COMPRESSED_SIGNED_RG_RGTC2;
+        case uvre::PixelFormat::BC7_UNORM:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
         default:
             return 0;
     }
 }
 
+static bool getCompressedFormat(uvre::PixelFormat format, uint32_t &internal_format, size_t &block_size)
+{
+    switch(format) {
+        case uvre::PixelFormat::BC1_UNORM:
+            internal_format = uvre::COMPRESSED_RGBA_S3TC_DXT1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC3_UNORM:
+            internal_format = uvre::COMPRESSED_RGBA_S3TC_DXT5;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC4_UNORM:
+            internal_format = GL_COMPRESSED_RED_RGTC1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC4_SNORM:
+            internal_format = GL_COMPRESSED_SIGNED_RED_RGTC1;
+            block_size = 8;
+            return true;
+        case uvre::PixelFormat::BC5_UNORM:
+            internal_format = GL_COMPRESSED_RG_RGTC2;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC5_SNORM:
+            internal_format = GL_COMPRESSED_SIGNED_RG_RGTC2;
+            block_size = 16;
+            return true;
+        case uvre::PixelFormat::BC7_UNORM:
+            internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+            block_size = 16;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline size_t getCompressedSize(size_t block_size, int w, int h, int d)
+{
+    const size_t blocks_x = static_cast<size_t>(w + 3) / 4;
+    const size_t blocks_y = static_cast<size_t>(h + 3) / 4;
+    return blocks_x * blocks_y * static_cast<size_t>(d) * block_size;
+}
+
+static bool isBlockAligned(const uvre::Texture_S *texture, int level, int x, int y, int w, int h)
+{
+    // Compressed regions must start on a block boundary and
+    // may only end off one when they touch the edge of the level.
+    const int level_width = std::max(1, texture->width >> level);
+    const int level_height = std::max(1, texture->height >> level);
+    if(x < 0 || y < 0 || x % 4 || y % 4)
+        return false;
+    if(w % 4 && x + w != level_width)
+        return false;
+    if(h % 4 && y + h != level_height)
+        return false;
+    return true;
+}
+
+// Returns false for formats that aren't compressed. Compressed writes
+// come back with a zero size when they don't fit the texture's blocks.
+static bool getCompressedWrite(const uvre::Texture_S *texture, uvre::PixelFormat format, int level, int x, int y, int w, int h, int d, uint32_t &internal_format, GLsizei &size)
+{
+    size_t block_size;
+    if(!getCompressedFormat(format, internal_format, block_size))
+        return false;
+    if(internal_format != texture->format || !isBlockAligned(texture, level, x, y, w, h))
+        size = 0;
+    else
+        size = static_cast<GLsizei>(getCompressedSize(block_size, w, h, d));
+    return true;
+}
+
+static bool isCompressionSupported(const uvre::DeviceInfo &info, uvre::PixelFormat format)
+{
+    switch(format) {
+        case uvre::PixelFormat::BC1_UNORM:
+        case uvre::PixelFormat::BC3_UNORM:
+            return info.supports_compression_s3tc;
+        case uvre::PixelFormat::BC4_UNORM:
+        case uvre::PixelFormat::BC4_SNORM:
+        case uvre::PixelFormat::BC5_UNORM:
+        case uvre::PixelFormat::BC5_SNORM:
+            return info.supports_compression_rgtc;
+        case uvre::PixelFormat::BC7_UNORM:
+            return info.supports_compression_bptc;
+        default:
+            return true;
+    }
+}
+
 uvre::Texture uvre::RenderDeviceImpl::createTexture(const uvre::TextureCreateInfo &info)
 {
     uint32_t texobj;
     uint32_t format = getInternalFormat(info.format);
+    uint32_t target;
     int32_t mip_levels = std::max<int32_t>(1, static_cast<int32_t>(info.mip_levels));
 
+    if(!isCompressionSupported(this->info, info.format))
+        return nullptr;
+
     switch(info.type) {
         case uvre::TextureType::TEXTURE_2D:
-            glCreateTextures(GL_TEXTURE_2D, 1, &texobj);
+            target = GL_TEXTURE_2D;
+            glCreateTextures(target, 1, &texobj);
             glTextureStorage2D(texobj, mip_levels, format, info.width, info.height);
             break;
         case uvre::TextureType::TEXTURE_CUBE:
-            glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &texobj);
+            target = GL_TEXTURE_CUBE_MAP;
+            glCreateTextures(target, 1, &texobj);
             glTextureStorage2D(texobj, mip_levels, format, info.width, info.height);
             break;
         case uvre::TextureType::TEXTURE_ARRAY:
-            glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texobj);
+            target = GL_TEXTURE_2D_ARRAY;
+            glCreateTextures(target, 1, &texobj);
             glTextureStorage3D(texobj, mip_levels, format, info.width, info.height, info.depth);
             break;
         default:
             return nullptr;
     }
 
-    uvre::Texture texture(new uvre::Texture_S, destroyTexture);
+    uvre::Texture texture(new uvre::Texture_S, std::bind(destroyTexture, std::placeholders::_1, this));
     texture->texobj = texobj;
     texture->format = format;
+    texture->target = target;
     texture->width = info.width;
     texture->height = info.height;
     texture->depth = info.depth;
+    texture->levels = mip_levels;
+    setObjectLabel(GL_TEXTURE, texobj, info.debug_name);
 
     return texture;
 }
@@ -827,28 +1675,414 @@ static bool getExternalFormat(uvre::PixelFormat format, uint32_t &fmt, uint32_t
     return true;
 }
 
-void uvre::RenderDeviceImpl::writeTexture2D(uvre::Texture texture, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+static size_t getUploadSize(uint32_t fmt, uint32_t type, int w, int h, int d)
+{
+    size_t components = 0;
+    switch(fmt) {
+        case GL_RED:
+            components = 1;
+            break;
+        case GL_RG:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        case GL_RGBA:
+            components = 4;
+            break;
+    }
+
+    size_t type_size = 0;
+    switch(type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            type_size = 1;
+            break;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            type_size = 2;
+            break;
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            type_size = 4;
+            break;
+    }
+
+    // GL_UNPACK_ALIGNMENT is never changed so rows
+    // are padded to four bytes, except for the last one.
+    const size_t row_size = static_cast<size_t>(w) * components * type_size;
+    const size_t row_pitch = (row_size + 3) & ~static_cast<size_t>(3);
+    const size_t rows = static_cast<size_t>(h) * static_cast<size_t>(d);
+    return rows ? row_pitch * (rows - 1) + row_size : 0;
+}
+
+void uvre::RenderDeviceImpl::writeTexture2D(uvre::Texture texture, int level, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glCompressedTextureSubImage2D(texture->texobj, level, x, y, w, h, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
-    glTextureSubImage2D(texture->texobj, 0, x, y, w, h, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, 1);
+    glTextureSubImage2D(texture->texobj, level, x, y, w, h, fmt, type, data);
 }
 
-void uvre::RenderDeviceImpl::writeTextureCube(uvre::Texture texture, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+void uvre::RenderDeviceImpl::writeTextureCube(uvre::Texture texture, int level, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glCompressedTextureSubImage3D(texture->texobj, level, x, y, face, w, h, 1, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
-    glTextureSubImage3D(texture->texobj, 0, x, y, face, w, h, 1, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, 1);
+    glTextureSubImage3D(texture->texobj, level, x, y, face, w, h, 1, fmt, type, data);
 }
 
-void uvre::RenderDeviceImpl::writeTextureArray(uvre::Texture texture, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
+void uvre::RenderDeviceImpl::writeTextureArray(uvre::Texture texture, int level, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
 {
     uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, d, fmt, size)) {
+        if(!size)
+            return;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            frame_stats.bytes_written += static_cast<size_t>(size);
+        glCompressedTextureSubImage3D(texture->texobj, level, x, y, z, w, h, d, fmt, size, data);
+        return;
+    }
+
     if(!getExternalFormat(format, fmt, type))
         return;
-    glTextureSubImage3D(texture->texobj, 0, x, y, z, w, h, d, fmt, type, data);
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.bytes_written += getUploadSize(fmt, type, w, h, d);
+    glTextureSubImage3D(texture->texobj, level, x, y, z, w, h, d, fmt, type, data);
+}
+
+static bool retireUpload(uvre::RenderDeviceImpl *device, GLuint64 timeout)
+{
+    if(device->upload.regions.empty())
+        return false;
+
+    const uvre::UploadRegion &region = device->upload.regions.front();
+    GLenum result = glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(region.fence);
+    device->upload.completed = region.ticket;
+    device->upload.regions.pop_front();
+    return true;
+}
+
+static size_t allocUpload(uvre::RenderDeviceImpl *device, size_t size)
+{
+    for(;;) {
+        // Find the oldest region that still occupies memory.
+        const uvre::UploadRegion *tail = nullptr;
+        for(const uvre::UploadRegion &region : device->upload.regions) {
+            if(!region.size)
+                continue;
+            tail = &region;
+            break;
+        }
+
+        if(!tail)
+            return 0;
+
+        // Strict comparisons here make sure that the head
+        // never catches up with the tail after wrapping around.
+        if(device->upload.head >= tail->offset) {
+            if(device->upload.head + size <= device->upload.size)
+                return device->upload.head;
+            if(size < tail->offset)
+                return 0;
+        }
+        else if(device->upload.head + size < tail->offset) {
+            return device->upload.head;
+        }
+
+        // The ring is full: we have to wait for the GPU.
+        retireUpload(device, std::numeric_limits<GLuint64>::max());
+    }
+}
+
+static uvre::UploadTicket pushUpload(uvre::RenderDeviceImpl *device, size_t size, const void *data, const std::function<void(const void *)> &write)
+{
+    // Offsets into a pixel unpack buffer must be
+    // aligned to the size of the texel component.
+    const size_t aligned_size = (size + 15) & ~static_cast<size_t>(15);
+
+    uvre::UploadRegion region = {};
+    region.ticket = ++device->upload.last_ticket;
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        device->frame_stats.bytes_written += size;
+
+    if(device->upload.mapped && aligned_size <= device->upload.size) {
+        region.offset = allocUpload(device, aligned_size);
+        region.size = aligned_size;
+        std::memcpy(device->upload.mapped + region.offset, data, size);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, device->upload.bufobj);
+        write(reinterpret_cast<const void *>(static_cast<uintptr_t>(region.offset)));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        device->upload.head = region.offset + aligned_size;
+    }
+    else {
+        // Doesn't fit into the ring, so the driver
+        // has to copy the data the slow way.
+        region.offset = device->upload.head;
+        region.size = 0;
+        write(data);
+    }
+
+    region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    device->upload.regions.push_back(region);
+    return region.ticket;
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTexture2D(uvre::Texture texture, int level, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glCompressedTextureSubImage2D(texture->texobj, level, x, y, w, h, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, 1), data, [&](const void *pixels) {
+        glTextureSubImage2D(texture->texobj, level, x, y, w, h, fmt, type, pixels);
+    });
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTextureCube(uvre::Texture texture, int level, int face, int x, int y, int w, int h, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, 1, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glCompressedTextureSubImage3D(texture->texobj, level, x, y, face, w, h, 1, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, 1), data, [&](const void *pixels) {
+        glTextureSubImage3D(texture->texobj, level, x, y, face, w, h, 1, fmt, type, pixels);
+    });
+}
+
+uvre::UploadTicket uvre::RenderDeviceImpl::uploadTextureArray(uvre::Texture texture, int level, int x, int y, int z, int w, int h, int d, uvre::PixelFormat format, const void *data)
+{
+    uint32_t fmt, type;
+    GLsizei size;
+    if(level < 0 || level >= texture->levels)
+        return 0;
+    issueBarrier(this, getPendingBits(hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+    if(getCompressedWrite(texture.get(), format, level, x, y, w, h, d, fmt, size)) {
+        if(!size)
+            return 0;
+        return pushUpload(this, static_cast<size_t>(size), data, [&](const void *pixels) {
+            glCompressedTextureSubImage3D(texture->texobj, level, x, y, z, w, h, d, fmt, size, pixels);
+        });
+    }
+
+    if(!getExternalFormat(format, fmt, type))
+        return 0;
+    return pushUpload(this, getUploadSize(fmt, type, w, h, d), data, [&](const void *pixels) {
+        glTextureSubImage3D(texture->texobj, level, x, y, z, w, h, d, fmt, type, pixels);
+    });
+}
+
+bool uvre::RenderDeviceImpl::isUploadComplete(uvre::UploadTicket ticket)
+{
+    while(ticket > upload.completed && retireUpload(this, 0))
+        continue;
+    return ticket <= upload.completed;
+}
+
+static void growBindlessPage(uvre::RenderDeviceImpl *device, uvre::BindlessPage &page)
+{
+    const int layers = std::min(page.layers ? page.layers * 2 : uvre::BINDLESS_PAGE_LAYERS, device->bindless.max_layers);
+
+    uint32_t texobj;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texobj);
+    glTextureStorage3D(texobj, page.levels, page.format, page.width, page.height, layers);
+    for(int i = 0; page.top && i < page.levels; i++)
+        glCopyImageSubData(page.texobj, GL_TEXTURE_2D_ARRAY, i, 0, 0, 0, texobj, GL_TEXTURE_2D_ARRAY, i, 0, 0, 0, std::max(1, page.width >> i), std::max(1, page.height >> i), page.top);
+    glDeleteTextures(1, &page.texobj);
+
+    page.texobj = texobj;
+    page.layers = layers;
+}
+
+static bool allocBindlessLayer(uvre::RenderDeviceImpl *device, uvre::Texture texture, uvre::Sampler sampler, uint32_t &page_index, int &layer)
+{
+    // Textures share a page when they look the same to
+    // the sampler: same size, format, mip chain and sampler.
+    uvre::BindlessPage *page = nullptr;
+    for(size_t i = 0; i < device->bindless.pages.size(); i++) {
+        uvre::BindlessPage &candidate = device->bindless.pages[i];
+        if(candidate.format != texture->format || candidate.width != texture->width || candidate.height != texture->height)
+            continue;
+        if(candidate.levels != texture->levels || candidate.sampler != sampler)
+            continue;
+        if(candidate.free_layers.empty() && candidate.top == candidate.layers && candidate.layers >= device->bindless.max_layers)
+            continue;
+        page = &candidate;
+        page_index = static_cast<uint32_t>(i);
+        break;
+    }
+
+    if(!page) {
+        if(device->bindless.pages.size() >= uvre::MAX_BINDLESS_PAGES)
+            return false;
+
+        uvre::BindlessPage new_page = {};
+        new_page.format = texture->format;
+        new_page.sampler = sampler;
+        new_page.width = texture->width;
+        new_page.height = texture->height;
+        new_page.levels = texture->levels;
+        device->bindless.pages.push_back(new_page);
+        page = &device->bindless.pages.back();
+        page_index = static_cast<uint32_t>(device->bindless.pages.size() - 1);
+    }
+
+    if(!page->free_layers.empty()) {
+        layer = page->free_layers.back();
+        page->free_layers.pop_back();
+    }
+    else {
+        if(page->top == page->layers)
+            growBindlessPage(device, *page);
+        layer = page->top++;
+    }
+
+    issueBarrier(device, getPendingBits(device->hazards.pending_textures, texture->texobj, GL_TEXTURE_UPDATE_BARRIER_BIT));
+    for(int i = 0; i < page->levels; i++)
+        glCopyImageSubData(texture->texobj, GL_TEXTURE_2D, i, 0, 0, 0, page->texobj, GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, std::max(1, page->width >> i), std::max(1, page->height >> i), 1);
+    return true;
+}
+
+uvre::BindlessTexture uvre::RenderDeviceImpl::createBindlessTexture(uvre::Texture texture, uvre::Sampler sampler)
+{
+    if(!bindless.enabled || !texture || texture->target != GL_TEXTURE_2D)
+        return 0;
+
+    uvre::BindlessEntry entry = {};
+    entry.texture = texture;
+    entry.sampler = sampler;
+    entry.in_use = true;
+
+    if(bindless.native) {
+        // The same texture/sampler pair always yields the
+        // same handle and it can only be made resident once.
+        entry.handle = sampler ? bindless.getTextureSamplerHandle(texture->texobj, sampler->ssobj) : bindless.getTextureHandle(texture->texobj);
+        if(!entry.handle)
+            return 0;
+        if(bindless.residency[entry.handle]++ == 0)
+            bindless.makeResident(entry.handle);
+    }
+    else if(!allocBindlessLayer(this, texture, sampler, entry.page, entry.layer)) {
+        return 0;
+    }
+
+    uvre::BindlessTexture index;
+    if(!bindless.free_entries.empty()) {
+        index = bindless.free_entries.back();
+        bindless.free_entries.pop_back();
+    }
+    else {
+        index = static_cast<uvre::BindlessTexture>(bindless.entries.size());
+        bindless.entries.emplace_back();
+        bindless.table.resize(bindless.entries.size() * 2, 0);
+    }
+
+    bindless.entries[index] = entry;
+    bindless.table[index * 2 + 0] = bindless.native ? static_cast<uint32_t>(entry.handle) : entry.page;
+    bindless.table[index * 2 + 1] = bindless.native ? static_cast<uint32_t>(entry.handle >> 32) : static_cast<uint32_t>(entry.layer);
+    bindless.dirty = true;
+    return index;
+}
+
+void uvre::RenderDeviceImpl::destroyBindlessTexture(uvre::BindlessTexture index)
+{
+    if(!index || index >= bindless.entries.size() || !bindless.entries[index].in_use)
+        return;
+
+    const uvre::BindlessEntry &entry = bindless.entries[index];
+    if(bindless.native) {
+        std::unordered_map<uint64_t, size_t>::iterator it = bindless.residency.find(entry.handle);
+        if(it != bindless.residency.end() && --it->second == 0) {
+            bindless.makeNonResident(entry.handle);
+            bindless.residency.erase(it);
+        }
+    }
+    else {
+        bindless.pages[entry.page].free_layers.push_back(entry.layer);
+    }
+
+    bindless.entries[index] = uvre::BindlessEntry {};
+    bindless.free_entries.push_back(index);
+    bindless.table[index * 2 + 0] = 0;
+    bindless.table[index * 2 + 1] = 0;
+    bindless.dirty = true;
+}
+
+static void attachTexture(uint32_t fbobj, uint32_t attachment, const uvre::Texture &texture, int level, int layer)
+{
+    // Cube maps take the face index as the layer.
+    if(layer < 0)
+        glNamedFramebufferTexture(fbobj, attachment, texture->texobj, level);
+    else
+        glNamedFramebufferTextureLayer(fbobj, attachment, texture->texobj, level, layer);
 }
 
 uvre::RenderTarget uvre::RenderDeviceImpl::createRenderTarget(const uvre::RenderTargetCreateInfo &info)
@@ -856,11 +2090,25 @@ uvre::RenderTarget uvre::RenderDeviceImpl::createRenderTarget(const uvre::Render
     uint32_t fbobj;
     glCreateFramebuffers(1, &fbobj);
     if(info.depth_attachment)
-        glNamedFramebufferTexture(fbobj, GL_DEPTH_ATTACHMENT, info.depth_attachment->texobj, 0);
+        attachTexture(fbobj, GL_DEPTH_ATTACHMENT, info.depth_attachment, info.depth_level, info.depth_layer);
     if(info.stencil_attachment)
-        glNamedFramebufferTexture(fbobj, GL_STENCIL_ATTACHMENT, info.stencil_attachment->texobj, 0);
+        attachTexture(fbobj, GL_STENCIL_ATTACHMENT, info.stencil_attachment, info.stencil_level, info.stencil_layer);
     for(size_t i = 0; i < info.num_color_attachments; i++)
-        glNamedFramebufferTexture(fbobj, GL_COLOR_ATTACHMENT0 + info.color_attachments[i].id, info.color_attachments[i].color->texobj, 0);
+        attachTexture(fbobj, GL_COLOR_ATTACHMENT0 + info.color_attachments[i].id, info.color_attachments[i].color, info.color_attachments[i].level, info.color_attachments[i].layer);
+
+    // Map draw buffer N to color attachment N so the
+    // fragment outputs and attachment clears line up.
+    std::vector<uint32_t> draw_buffers;
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        const uint32_t id = info.color_attachments[i].id;
+        if(draw_buffers.size() <= id)
+            draw_buffers.resize(id + 1, GL_NONE);
+        draw_buffers[id] = GL_COLOR_ATTACHMENT0 + id;
+    }
+
+    if(draw_buffers.empty())
+        draw_buffers.push_back(GL_NONE);
+    glNamedFramebufferDrawBuffers(fbobj, static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
 
     if(glCheckNamedFramebufferStatus(fbobj, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         glDeleteFramebuffers(1, &fbobj);
@@ -869,10 +2117,135 @@ uvre::RenderTarget uvre::RenderDeviceImpl::createRenderTarget(const uvre::Render
 
     uvre::RenderTarget target(new uvre::RenderTarget_S, destroyRenderTarget);
     target->fbobj = fbobj;
+    setObjectLabel(GL_FRAMEBUFFER, fbobj, info.debug_name);
 
     return target;
 }
 
+static bool compareBindGroupEntries(const uvre::BindGroupEntry &a, const uvre::BindGroupEntry &b)
+{
+    if(a.type != b.type)
+        return a.type < b.type;
+    return a.index < b.index;
+}
+
+uvre::BindGroup uvre::RenderDeviceImpl::createBindGroup(const uvre::BindGroupCreateInfo &info)
+{
+    uvre::BindGroup group(new uvre::BindGroup_S);
+    group->id = next_object_id++;
+    group->slots = 0;
+    group->entries.assign(info.entries, info.entries + info.num_entries);
+
+    // Sorted entries turn every run of consecutive
+    // slots of a type into a single multi-bind call.
+    std::sort(group->entries.begin(), group->entries.end(), compareBindGroupEntries);
+
+    for(const uvre::BindGroupEntry &entry : group->entries) {
+        uint32_t object = 0;
+        size_t size = 0;
+        switch(entry.type) {
+            case uvre::BindingType::UNIFORM_BUFFER:
+            case uvre::BindingType::STORAGE_BUFFER:
+                if(entry.buffer) {
+                    object = entry.buffer->bufobj;
+                    size = entry.size ? entry.size : entry.buffer->size - entry.offset;
+                }
+                break;
+            case uvre::BindingType::SAMPLER:
+                object = entry.sampler ? entry.sampler->ssobj : 0;
+                break;
+            case uvre::BindingType::TEXTURE:
+                object = entry.texture ? entry.texture->texobj : 0;
+                break;
+        }
+
+        if(group->runs.empty() || group->runs.back().type != entry.type || group->runs.back().first + group->runs.back().count != entry.index)
+            group->runs.push_back(uvre::BindGroupRun { entry.type, entry.index, 0, group->objects.size() });
+        group->runs.back().count++;
+
+        group->objects.push_back(object);
+        group->offsets.push_back(static_cast<GLintptr>(entry.offset));
+        group->sizes.push_back(static_cast<GLsizeiptr>(size));
+        group->writable.push_back(entry.type == uvre::BindingType::STORAGE_BUFFER && entry.writable);
+        group->slots |= getSlotBit(entry.index);
+    }
+
+    return group;
+}
+
+static bool isSameTransientTarget(const uvre::TransientTargetEntry &entry, const uvre::TransientTargetCreateInfo &info)
+{
+    if(entry.width != info.width || entry.height != info.height || entry.num_color_attachments != info.num_color_attachments)
+        return false;
+    if(entry.use_depth != info.use_depth || (info.use_depth && entry.depth_format != info.depth_format))
+        return false;
+    return std::equal(info.color_formats, info.color_formats + info.num_color_attachments, entry.color_formats);
+}
+
+uvre::TransientTarget uvre::RenderDeviceImpl::acquireTransientTarget(const uvre::TransientTargetCreateInfo &info)
+{
+    if(info.num_color_attachments > uvre::MAX_COLOR_ATTACHMENTS)
+        return uvre::TransientTarget {};
+
+    for(uvre::TransientTargetEntry &entry : transient_targets) {
+        if(entry.in_use || !isSameTransientTarget(entry, info))
+            continue;
+        entry.in_use = true;
+        entry.last_frame = frame_count;
+        return entry.target;
+    }
+
+    uvre::TransientTargetEntry entry = {};
+    entry.width = info.width;
+    entry.height = info.height;
+    entry.num_color_attachments = info.num_color_attachments;
+    entry.use_depth = info.use_depth;
+    entry.depth_format = info.depth_format;
+    std::copy(info.color_formats, info.color_formats + info.num_color_attachments, entry.color_formats);
+
+    uvre::TextureCreateInfo texture_info = {};
+    texture_info.type = uvre::TextureType::TEXTURE_2D;
+    texture_info.width = info.width;
+    texture_info.height = info.height;
+
+    uvre::ColorAttachment attachments[uvre::MAX_COLOR_ATTACHMENTS];
+    for(size_t i = 0; i < info.num_color_attachments; i++) {
+        texture_info.format = info.color_formats[i];
+        entry.target.color[i] = createTexture(texture_info);
+        attachments[i].id = static_cast<uint32_t>(i);
+        attachments[i].color = entry.target.color[i];
+    }
+
+    uvre::RenderTargetCreateInfo target_info = {};
+    target_info.num_color_attachments = info.num_color_attachments;
+    target_info.color_attachments = attachments;
+
+    if(info.use_depth) {
+        texture_info.format = info.depth_format;
+        entry.target.depth = createTexture(texture_info);
+        target_info.depth_attachment = entry.target.depth;
+    }
+
+    entry.target.target = createRenderTarget(target_info);
+    if(!entry.target.target)
+        return uvre::TransientTarget {};
+
+    entry.in_use = true;
+    entry.last_frame = frame_count;
+    transient_targets.push_back(entry);
+    return entry.target;
+}
+
+void uvre::RenderDeviceImpl::releaseTransientTarget(const uvre::TransientTarget &target)
+{
+    for(uvre::TransientTargetEntry &entry : transient_targets) {
+        if(entry.target.target != target.target)
+            continue;
+        entry.in_use = false;
+        return;
+    }
+}
+
 uvre::ICommandList *uvre::RenderDeviceImpl::createCommandList()
 {
     uvre::CommandListImpl *commands = new uvre::CommandListImpl();
@@ -895,14 +2268,372 @@ void uvre::RenderDeviceImpl::startRecording(uvre::ICommandList *commands)
 {
     uvre::CommandListImpl *glcommands = static_cast<uvre::CommandListImpl *>(commands);
     glcommands->num_commands = 0;
+    glcommands->names.clear();
+    glcommands->groups.clear();
+}
+
+static size_t getPassAttachments(uint32_t target, uint32_t mask, uint32_t *attachments)
+{
+    size_t count = 0;
+
+    if(!target) {
+        // The default framebuffer has its own attachment names
+        if(mask & ((1 << uvre::MAX_PASS_COLOR_ATTACHMENTS) - 1))
+            attachments[count++] = GL_COLOR;
+        if(mask & uvre::PASS_DEPTH_ATTACHMENT)
+            attachments[count++] = GL_DEPTH;
+        if(mask & uvre::PASS_STENCIL_ATTACHMENT)
+            attachments[count++] = GL_STENCIL;
+        return count;
+    }
+
+    for(uint32_t i = 0; i < uvre::MAX_PASS_COLOR_ATTACHMENTS; i++) {
+        if(mask & (1 << i))
+            attachments[count++] = GL_COLOR_ATTACHMENT0 + i;
+    }
+
+    if(mask & uvre::PASS_DEPTH_ATTACHMENT)
+        attachments[count++] = GL_DEPTH_ATTACHMENT;
+    if(mask & uvre::PASS_STENCIL_ATTACHMENT)
+        attachments[count++] = GL_STENCIL_ATTACHMENT;
+    return count;
+}
+
+static void bindBindlessTable(uvre::RenderDeviceImpl *device)
+{
+    if(device->bindless.dirty) {
+        const size_t size = device->bindless.table.size() * sizeof(uint32_t);
+        glNamedBufferData(device->bindless.bufobj, static_cast<GLsizeiptr>(size), device->bindless.table.data(), GL_DYNAMIC_DRAW);
+        device->bindless.dirty = false;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, uvre::BINDLESS_TABLE_BINDING, device->bindless.bufobj);
+    for(size_t i = 0; i < device->bindless.pages.size(); i++) {
+        const uvre::BindlessPage &page = device->bindless.pages[i];
+        glBindTextureUnit(static_cast<uint32_t>(uvre::BINDLESS_PAGE_UNIT + i), page.texobj);
+        glBindSampler(static_cast<uint32_t>(uvre::BINDLESS_PAGE_UNIT + i), page.sampler ? page.sampler->ssobj : 0);
+    }
+}
+
+static const uvre::Pipeline_S *resolvePipeline(uvre::RenderDeviceImpl *device, const uvre::Pipeline_S *pipeline)
+{
+    if(!pipeline)
+        return nullptr;
+
+    uvre::PendingPipeline *pending = pipeline->pending;
+    if(!pending || pending->ready)
+        return pipeline;
+
+    // Broken pipelines stay on the placeholder for good,
+    // without one whatever they were going to draw is skipped.
+    if(pending->failed)
+        return resolvePipeline(device, pending->placeholder.get());
+
+    // Draw with the placeholder until the shaders are done. Without
+    // one there's nothing left to do but to wait for the compiler.
+    const bool wait = !pending->placeholder;
+    for(const uvre::Shader &shader : pending->shaders) {
+        if(!finishShader(device, shader.get(), wait))
+            return resolvePipeline(device, pending->placeholder.get());
+    }
+
+    for(const uvre::Shader &shader : pending->shaders) {
+        if(!shader->prog) {
+            pending->failed = true;
+            return resolvePipeline(device, pending->placeholder.get());
+        }
+    }
+
+    for(const uvre::Shader &shader : pending->shaders) {
+        glUseProgramStages(pipeline->ppobj, shader->stage_bit, shader->prog);
+        pending->storage_mask |= shader->storage_mask;
+        pending->image_mask |= shader->image_mask;
+    }
+
+    pending->ready = true;
+    return pipeline;
+}
+
+static void applyBindGroup(const uvre::BindGroup_S *group)
+{
+    for(const uvre::BindGroupRun &run : group->runs) {
+        const uint32_t *objects = group->objects.data() + run.offset;
+        const GLintptr *offsets = group->offsets.data() + run.offset;
+        const GLsizeiptr *sizes = group->sizes.data() + run.offset;
+        switch(run.type) {
+            case uvre::BindingType::UNIFORM_BUFFER:
+                glBindBuffersRange(GL_UNIFORM_BUFFER, run.first, static_cast<GLsizei>(run.count), objects, offsets, sizes);
+                break;
+            case uvre::BindingType::STORAGE_BUFFER:
+                glBindBuffersRange(GL_SHADER_STORAGE_BUFFER, run.first, static_cast<GLsizei>(run.count), objects, offsets, sizes);
+                break;
+            case uvre::BindingType::SAMPLER:
+                glBindSamplers(run.first, static_cast<GLsizei>(run.count), objects);
+                break;
+            case uvre::BindingType::TEXTURE:
+                glBindTextures(run.first, static_cast<GLsizei>(run.count), objects);
+                break;
+        }
+    }
+}
+
+static void invalidateBindGroups(const uvre::BindGroup_S **bound_groups, uint32_t slots)
+{
+    for(uint32_t i = 0; i < uvre::MAX_BIND_GROUPS; i++) {
+        if(bound_groups[i] && (bound_groups[i]->slots & slots))
+            bound_groups[i] = nullptr;
+    }
+}
+
+static bool batchBind(uvre::BindBatch &batch, uint32_t index, uint32_t object)
+{
+    if(index >= uvre::MAX_BATCHED_BINDINGS)
+        return false;
+    batch.mask |= (1U << index);
+    batch.objects[index] = object;
+    return true;
+}
+
+static void flushBindBatch(uvre::BindBatch &batch, uvre::CommandType type)
+{
+    // Every run of consecutive slots becomes a single call,
+    // so binding units 0..7 costs one call instead of eight.
+    uint32_t first = 0;
+    while(batch.mask) {
+        while(!(batch.mask & (1U << first)))
+            first++;
+
+        uint32_t count = 0;
+        while(first + count < uvre::MAX_BATCHED_BINDINGS && (batch.mask & (1U << (first + count))))
+            batch.mask &= ~(1U << (first + count++));
+
+        switch(type) {
+            case uvre::CommandType::BIND_STORAGE_BUFFER:
+                glBindBuffersBase(GL_SHADER_STORAGE_BUFFER, first, static_cast<GLsizei>(count), batch.objects + first);
+                break;
+            case uvre::CommandType::BIND_UNIFORM_BUFFER:
+                glBindBuffersBase(GL_UNIFORM_BUFFER, first, static_cast<GLsizei>(count), batch.objects + first);
+                break;
+            case uvre::CommandType::BIND_SAMPLER:
+                glBindSamplers(first, static_cast<GLsizei>(count), batch.objects + first);
+                break;
+            case uvre::CommandType::BIND_TEXTURE:
+                glBindTextures(first, static_cast<GLsizei>(count), batch.objects + first);
+                break;
+            default:
+                break;
+        }
+
+        first += count;
+    }
+}
+
+static uint32_t allocTimerQuery(uvre::RenderDeviceImpl *device)
+{
+    if(device->timers.free_queries.empty()) {
+        uint32_t queries[uvre::TIMER_QUERY_BATCH];
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(uvre::TIMER_QUERY_BATCH), queries);
+        device->timers.free_queries.assign(queries, queries + uvre::TIMER_QUERY_BATCH);
+    }
+
+    const uint32_t query = device->timers.free_queries.back();
+    device->timers.free_queries.pop_back();
+    return query;
+}
+
+static void beginTimer(uvre::RenderDeviceImpl *device, const std::string &name)
+{
+    if(device->timers.frames.empty())
+        device->timers.frames.emplace_back();
+
+    uvre::TimerRegion region = {};
+    region.name = name;
+    region.queries[0] = allocTimerQuery(device);
+    region.queries[1] = allocTimerQuery(device);
+    region.ended = false;
+    glQueryCounter(region.queries[0], GL_TIMESTAMP);
+
+    uvre::TimerFrame &frame = device->timers.frames.back();
+    device->timers.open.push_back(frame.regions.size());
+    frame.regions.push_back(region);
+}
+
+static void endTimer(uvre::RenderDeviceImpl *device)
+{
+    if(device->timers.open.empty() || device->timers.frames.empty())
+        return;
+
+    uvre::TimerRegion &region = device->timers.frames.back().regions[device->timers.open.back()];
+    device->timers.open.pop_back();
+    glQueryCounter(region.queries[1], GL_TIMESTAMP);
+    region.ended = true;
+}
+
+// Frames are read back in order and only once every query
+// is available, so asking for the results never stalls.
+static bool readTimerFrame(uvre::RenderDeviceImpl *device, const uvre::TimerFrame &frame)
+{
+    for(const uvre::TimerRegion &region : frame.regions) {
+        int32_t available = GL_TRUE;
+        if(region.ended)
+            glGetQueryObjectiv(region.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            return false;
+    }
+
+    device->timers.names.clear();
+    device->timers.results.clear();
+    for(const uvre::TimerRegion &region : frame.regions) {
+        if(region.ended) {
+            uint64_t begin, end;
+            glGetQueryObjectui64v(region.queries[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(region.queries[1], GL_QUERY_RESULT, &end);
+            device->timers.names.push_back(region.name);
+            device->timers.results.push_back(uvre::TimerResult { nullptr, static_cast<double>(end - begin) / 1000000.0 });
+        }
+
+        device->timers.free_queries.push_back(region.queries[0]);
+        device->timers.free_queries.push_back(region.queries[1]);
+    }
+
+    // Names can only be pointed to once the vector stops growing
+    for(size_t i = 0; i < device->timers.results.size(); i++)
+        device->timers.results[i].name = device->timers.names[i].c_str();
+    return true;
+}
+
+static size_t getPrimitiveCount(uint32_t mode, int32_t count)
+{
+    const size_t n = static_cast<size_t>(std::max(count, 0));
+    switch(mode) {
+        case GL_LINES:
+            return n / 2;
+        case GL_LINE_STRIP:
+            return n ? n - 1 : 0;
+        case GL_TRIANGLES:
+            return n / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            return n > 2 ? n - 2 : 0;
+        default:
+            return n;
+    }
+}
+
+static void countCommand(uvre::FrameStats &stats, const uvre::Command &cmd, uint32_t mode)
+{
+    stats.num_commands++;
+    switch(cmd.type) {
+        case uvre::CommandType::BIND_STORAGE_BUFFER:
+            stats.num_binds++;
+            stats.binds.storage_buffers++;
+            break;
+        case uvre::CommandType::BIND_UNIFORM_BUFFER:
+            stats.num_binds++;
+            stats.binds.uniform_buffers++;
+            break;
+        case uvre::CommandType::BIND_INDEX_BUFFER:
+            stats.num_binds++;
+            stats.binds.index_buffers++;
+            break;
+        case uvre::CommandType::BIND_VERTEX_BUFFER:
+            stats.num_binds++;
+            stats.binds.vertex_buffers++;
+            break;
+        case uvre::CommandType::BIND_SAMPLER:
+            stats.num_binds++;
+            stats.binds.samplers++;
+            break;
+        case uvre::CommandType::BIND_TEXTURE:
+            stats.num_binds++;
+            stats.binds.textures++;
+            break;
+        case uvre::CommandType::BIND_IMAGE:
+            stats.num_binds++;
+            stats.binds.images++;
+            break;
+        case uvre::CommandType::BIND_GROUP:
+            stats.num_binds++;
+            stats.binds.groups++;
+            break;
+        case uvre::CommandType::CLEAR:
+        case uvre::CommandType::CLEAR_ATTACHMENT:
+            stats.num_clears++;
+            break;
+        case uvre::CommandType::COPY_TEXTURE:
+        case uvre::CommandType::COPY_RENDER_TARGET:
+            stats.num_copies++;
+            break;
+        case uvre::CommandType::WRITE_BUFFER:
+            stats.bytes_written += cmd.buffer_write.size;
+            break;
+        case uvre::CommandType::DRAW:
+            stats.num_draws++;
+            stats.num_instances += static_cast<size_t>(cmd.draw.a.instances);
+            stats.num_primitives += getPrimitiveCount(mode, cmd.draw.a.vertices) * static_cast<size_t>(cmd.draw.a.instances);
+            break;
+        case uvre::CommandType::IDRAW:
+            stats.num_draws++;
+            stats.num_instances += static_cast<size_t>(cmd.draw.e.instances);
+            stats.num_primitives += getPrimitiveCount(mode, cmd.draw.e.indices) * static_cast<size_t>(cmd.draw.e.instances);
+            break;
+        case uvre::CommandType::DISPATCH:
+        case uvre::CommandType::DISPATCH_INDIRECT:
+            stats.num_dispatches++;
+            break;
+        default:
+            break;
+    }
+}
+
+static double getElapsedTime(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
 {
     uvre::CommandListImpl *glcommands = static_cast<uvre::CommandListImpl *>(commands);
+    uint32_t attachments[uvre::MAX_PASS_COLOR_ATTACHMENTS + 2];
+    size_t num_attachments;
+
+    uvre::BindBatch storage_buffers = {};
+    uvre::BindBatch uniform_buffers = {};
+    uvre::BindBatch samplers = {};
+    uvre::BindBatch textures = {};
+    const uvre::BindGroup_S *bound_groups[uvre::MAX_BIND_GROUPS] = {};
+    const uvre::Pipeline_S *resolved;
+    bool skip_draws = false;
+
+    const std::chrono::steady_clock::time_point start = uvre::FRAME_STATS_ENABLED ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point {};
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.num_submits++;
+
+    if(bindless.enabled)
+        bindBindlessTable(this);
+
     for(size_t i = 0; i < glcommands->num_commands; i++) {
         const uvre::Command &cmd = glcommands->commands[i];
         uvre::VertexArray_S *vaonode = nullptr;
+        if constexpr(uvre::FRAME_STATS_ENABLED)
+            countCommand(frame_stats, cmd, bound_pipeline.primitive_mode);
+
+        // Resource binds are held back until something
+        // that might depend on them is about to happen.
+        switch(cmd.type) {
+            case uvre::CommandType::BIND_STORAGE_BUFFER:
+            case uvre::CommandType::BIND_UNIFORM_BUFFER:
+            case uvre::CommandType::BIND_SAMPLER:
+            case uvre::CommandType::BIND_TEXTURE:
+                break;
+            default:
+                flushBindBatch(storage_buffers, uvre::CommandType::BIND_STORAGE_BUFFER);
+                flushBindBatch(uniform_buffers, uvre::CommandType::BIND_UNIFORM_BUFFER);
+                flushBindBatch(samplers, uvre::CommandType::BIND_SAMPLER);
+                flushBindBatch(textures, uvre::CommandType::BIND_TEXTURE);
+                break;
+        }
+
         switch(cmd.type) {
             case uvre::CommandType::SET_SCISSOR:
                 glScissor(cmd.scvp.x, cmd.scvp.y, cmd.scvp.w, cmd.scvp.h);
@@ -919,8 +2650,46 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
             case uvre::CommandType::CLEAR:
                 glClear(cmd.clear_mask);
                 break;
+            case uvre::CommandType::BEGIN_RENDER_PASS:
+                if(cmd.pass.attachments) {
+                    num_attachments = getPassAttachments(cmd.pass.target, cmd.pass.attachments, attachments);
+                    glInvalidateNamedFramebufferData(cmd.pass.target, static_cast<GLsizei>(num_attachments), attachments);
+                }
+                issueBarrier(this, getAnyPendingBits(hazards.pending_textures, GL_FRAMEBUFFER_BARRIER_BIT));
+                glBindFramebuffer(GL_FRAMEBUFFER, cmd.pass.target);
+                break;
+            case uvre::CommandType::CLEAR_ATTACHMENT:
+                // Load actions clear the whole attachment
+                if(bound_pipeline.scissor_test)
+                    glDisable(GL_SCISSOR_TEST);
+                if(cmd.attachment_clear.buffer == GL_COLOR)
+                    glClearNamedFramebufferfv(cmd.attachment_clear.target, GL_COLOR, cmd.attachment_clear.drawbuffer, cmd.attachment_clear.color);
+                else if(cmd.attachment_clear.buffer == GL_DEPTH)
+                    glClearNamedFramebufferfv(cmd.attachment_clear.target, GL_DEPTH, 0, &cmd.attachment_clear.depth);
+                else
+                    glClearNamedFramebufferiv(cmd.attachment_clear.target, GL_STENCIL, 0, &cmd.attachment_clear.stencil);
+                if(bound_pipeline.scissor_test)
+                    glEnable(GL_SCISSOR_TEST);
+                break;
+            case uvre::CommandType::END_RENDER_PASS:
+                if(cmd.pass.attachments) {
+                    num_attachments = getPassAttachments(cmd.pass.target, cmd.pass.attachments, attachments);
+                    glInvalidateNamedFramebufferData(cmd.pass.target, static_cast<GLsizei>(num_attachments), attachments);
+                }
+                break;
             case uvre::CommandType::BIND_PIPELINE:
-                bound_pipeline = cmd.pipeline;
+                resolved = resolvePipeline(this, &cmd.pipeline);
+                skip_draws = !resolved;
+                if(!resolved || resolved->id == bound_pipeline.id)
+                    break;
+                bound_pipeline = *resolved;
+                if(bound_pipeline.pending) {
+                    // The stages that were compiled later
+                    bound_pipeline.storage_mask |= bound_pipeline.pending->storage_mask;
+                    bound_pipeline.image_mask |= bound_pipeline.pending->image_mask;
+                }
+                if constexpr(uvre::FRAME_STATS_ENABLED)
+                    frame_stats.num_pipeline_switches++;
                 glDisable(GL_BLEND);
                 glDisable(GL_DEPTH_TEST);
                 glDisable(GL_CULL_FACE);
@@ -945,19 +2714,28 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
                 glBindProgramPipeline(bound_pipeline.ppobj);
                 break;
             case uvre::CommandType::BIND_STORAGE_BUFFER:
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, cmd.bind_index, cmd.object);
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
+                setHazardSlot(hazards.storage_slots, cmd.bind_index, cmd.storage.bufobj, cmd.storage.writable);
+                if(!batchBind(storage_buffers, cmd.bind_index, cmd.storage.bufobj))
+                    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, cmd.bind_index, cmd.storage.bufobj);
                 break;
             case uvre::CommandType::BIND_UNIFORM_BUFFER:
-                glBindBufferBase(GL_UNIFORM_BUFFER, cmd.bind_index, cmd.object);
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
+                setHazardSlot(hazards.uniform_slots, cmd.bind_index, cmd.object, false);
+                if(!batchBind(uniform_buffers, cmd.bind_index, cmd.object))
+                    glBindBufferBase(GL_UNIFORM_BUFFER, cmd.bind_index, cmd.object);
                 break;
             case uvre::CommandType::BIND_INDEX_BUFFER: // OPTIMIZE
                 bound_pipeline.bound_ibo = cmd.object;
                 break;
             case uvre::CommandType::BIND_VERTEX_BUFFER: // OPTIMIZE
+                hazards.vertex_buffer = cmd.buffer.bufobj;
                 vaonode = getVertexArray(&bound_pipeline.vaos, cmd.buffer.vbo->index / max_vbo_bindings, &bound_pipeline);
                 if(vaonode->vaobj != bound_pipeline.bound_vao) {
                     bound_pipeline.bound_vao = vaonode->vaobj;
                     glBindVertexArray(vaonode->vaobj);
+                    if constexpr(uvre::FRAME_STATS_ENABLED)
+                        frame_stats.num_vao_switches++;
                 }
                 if(vaonode->vbobj != cmd.buffer.bufobj) {
                     vaonode->vbobj = cmd.buffer.bufobj;
@@ -967,28 +2745,103 @@ void uvre::RenderDeviceImpl::submit(uvre::ICommandList *commands)
                 }
                 break;
             case uvre::CommandType::BIND_SAMPLER:
-                glBindSampler(cmd.bind_index, cmd.object);
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
+                if(!batchBind(samplers, cmd.bind_index, cmd.object))
+                    glBindSampler(cmd.bind_index, cmd.object);
                 break;
             case uvre::CommandType::BIND_TEXTURE:
-                glBindTextureUnit(cmd.bind_index, cmd.object);
+                invalidateBindGroups(bound_groups, getSlotBit(cmd.bind_index));
+                setHazardSlot(hazards.texture_slots, cmd.bind_index, cmd.object, false);
+                if(!batchBind(textures, cmd.bind_index, cmd.object))
+                    glBindTextureUnit(cmd.bind_index, cmd.object);
                 break;
             case uvre::CommandType::BIND_RENDER_TARGET:
+                issueBarrier(this, getAnyPendingBits(hazards.pending_textures, GL_FRAMEBUFFER_BARRIER_BIT));
                 glBindFramebuffer(GL_FRAMEBUFFER, cmd.object);
                 break;
+            case uvre::CommandType::BIND_IMAGE:
+                setHazardSlot(hazards.image_slots, cmd.bind_index, cmd.image.texobj, cmd.image.access != GL_READ_ONLY);
+                glBindImageTexture(cmd.bind_index, cmd.image.texobj, cmd.image.level, cmd.image.layer < 0 ? GL_TRUE : GL_FALSE, std::max(cmd.image.layer, 0), cmd.image.access, getInternalFormat(cmd.image.format));
+                break;
+            case uvre::CommandType::BIND_GROUP:
+                if(cmd.bind_index < uvre::MAX_BIND_GROUPS && bound_groups[cmd.bind_index] && bound_groups[cmd.bind_index]->id == cmd.group->id)
+                    break;
+                invalidateBindGroups(bound_groups, cmd.group->slots);
+                if(cmd.bind_index < uvre::MAX_BIND_GROUPS)
+                    bound_groups[cmd.bind_index] = cmd.group;
+                trackBindGroup(this, cmd.group);
+                applyBindGroup(cmd.group);
+                break;
             case uvre::CommandType::WRITE_BUFFER:
+                issueBarrier(this, getPendingBits(hazards.pending_buffers, cmd.buffer_write.buffer, GL_BUFFER_UPDATE_BARRIER_BIT));
                 glNamedBufferSubData(cmd.buffer_write.buffer, static_cast<GLintptr>(cmd.buffer_write.offset), static_cast<GLsizeiptr>(cmd.buffer_write.size), cmd.buffer_write.data_ptr);
                 break;
+            case uvre::CommandType::GENERATE_MIPMAPS:
+                issueBarrier(this, getPendingBits(hazards.pending_textures, cmd.object, GL_TEXTURE_UPDATE_BARRIER_BIT));
+                glGenerateTextureMipmap(cmd.object);
+                break;
+            case uvre::CommandType::COPY_TEXTURE:
+                issueBarrier(this, getPendingBits(hazards.pending_textures, cmd.tex_copy.src, GL_TEXTURE_UPDATE_BARRIER_BIT) | getPendingBits(hazards.pending_textures, cmd.tex_copy.dst, GL_TEXTURE_UPDATE_BARRIER_BIT));
+                glCopyImageSubData(cmd.tex_copy.src, cmd.tex_copy.src_target, cmd.tex_copy.src_level, cmd.tex_copy.sx, cmd.tex_copy.sy, cmd.tex_copy.sz, cmd.tex_copy.dst, cmd.tex_copy.dst_target, cmd.tex_copy.dst_level, cmd.tex_copy.dx, cmd.tex_copy.dy, cmd.tex_copy.dz, cmd.tex_copy.w, cmd.tex_copy.h, cmd.tex_copy.d);
+                break;
             case uvre::CommandType::COPY_RENDER_TARGET:
+                issueBarrier(this, getAnyPendingBits(hazards.pending_textures, GL_FRAMEBUFFER_BARRIER_BIT));
                 glBlitNamedFramebuffer(cmd.rt_copy.src, cmd.rt_copy.dst, cmd.rt_copy.sx0, cmd.rt_copy.sy0, cmd.rt_copy.sx1, cmd.rt_copy.sy1, cmd.rt_copy.dx0, cmd.rt_copy.dy0, cmd.rt_copy.dx1, cmd.rt_copy.dy1, cmd.rt_copy.mask, cmd.rt_copy.filter);
                 break;
             case uvre::CommandType::DRAW:
+                if(skip_draws)
+                    break;
+                resolveHazards(this, true, 0, 0);
                 glDrawArraysInstancedBaseInstance(bound_pipeline.primitive_mode, cmd.draw.a.base_vertex, cmd.draw.a.vertices, cmd.draw.a.instances, cmd.draw.a.base_instance);
+                markWritten(this);
                 break;
             case uvre::CommandType::IDRAW:
+                if(skip_draws)
+                    break;
+                resolveHazards(this, true, bound_pipeline.bound_ibo, 0);
                 glDrawElementsInstancedBaseVertexBaseInstance(bound_pipeline.primitive_mode, cmd.draw.e.indices, bound_pipeline.index_type, reinterpret_cast<const void *>(static_cast<uintptr_t>(bound_pipeline.index_size * cmd.draw.e.base_index)), cmd.draw.e.instances, cmd.draw.e.base_vertex, cmd.draw.e.base_instance);
+                markWritten(this);
+                break;
+            case uvre::CommandType::DISPATCH:
+                if(skip_draws)
+                    break;
+                resolveHazards(this, false, 0, 0);
+                glDispatchCompute(cmd.dispatch.x, cmd.dispatch.y, cmd.dispatch.z);
+                markWritten(this);
+                break;
+            case uvre::CommandType::DISPATCH_INDIRECT:
+                if(skip_draws)
+                    break;
+                resolveHazards(this, false, 0, cmd.indirect.buffer);
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, cmd.indirect.buffer);
+                glDispatchComputeIndirect(static_cast<GLintptr>(cmd.indirect.offset));
+                markWritten(this);
+                break;
+            case uvre::CommandType::MEMORY_BARRIER:
+                issueBarrier(this, cmd.barriers);
+                break;
+            case uvre::CommandType::BEGIN_TIMER:
+                beginTimer(this, glcommands->names[cmd.object]);
+                break;
+            case uvre::CommandType::END_TIMER:
+                endTimer(this);
+                break;
+            case uvre::CommandType::PUSH_DEBUG_GROUP:
+                glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, glcommands->names[cmd.object].c_str());
+                break;
+            case uvre::CommandType::POP_DEBUG_GROUP:
+                glPopDebugGroup();
                 break;
         }
     }
+
+    flushBindBatch(storage_buffers, uvre::CommandType::BIND_STORAGE_BUFFER);
+    flushBindBatch(uniform_buffers, uvre::CommandType::BIND_UNIFORM_BUFFER);
+    flushBindBatch(samplers, uvre::CommandType::BIND_SAMPLER);
+    flushBindBatch(textures, uvre::CommandType::BIND_TEXTURE);
+
+    if constexpr(uvre::FRAME_STATS_ENABLED)
+        frame_stats.submit_time += getElapsedTime(start);
 }
 
 void uvre::RenderDeviceImpl::prepare()
@@ -996,11 +2849,53 @@ void uvre::RenderDeviceImpl::prepare()
     // Third-party overlay applications
     // can cause mayhem if this is not called.
     glUseProgram(0);
+
+    // Don't let the CPU run too far ahead, otherwise
+    // the latency depends on how much the driver queues.
+    const auto start = std::chrono::steady_clock::now();
+    while(create_info.max_frames_in_flight > 0 && pacing.fences.size() >= static_cast<size_t>(create_info.max_frames_in_flight)) {
+        GLenum result;
+        do {
+            result = glClientWaitSync(pacing.fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, uvre::FRAME_FENCE_TIMEOUT);
+        } while(result == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(pacing.fences.front());
+        pacing.fences.pop_front();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    pacing.wait_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+    last_frame_stats = frame_stats;
+    frame_stats = uvre::FrameStats {};
+
+    // Release staging memory of finished uploads
+    while(retireUpload(this, 0))
+        continue;
+
+    // Timers left open keep their frame going
+    while(timers.frames.size() > 1 && readTimerFrame(this, timers.frames.front()))
+        timers.frames.pop_front();
+    if(timers.open.empty() && (timers.frames.empty() || !timers.frames.back().regions.empty()))
+        timers.frames.emplace_back();
+
+    // Recycle the transient targets and drop the
+    // ones nobody asked for in a few frames.
+    frame_count++;
+    for(std::vector<uvre::TransientTargetEntry>::iterator it = transient_targets.begin(); it != transient_targets.end();) {
+        it->in_use = false;
+        if(frame_count - it->last_frame > uvre::TRANSIENT_TARGET_LIFETIME) {
+            it = transient_targets.erase(it);
+            continue;
+        }
+        it++;
+    }
 }
 
 void uvre::RenderDeviceImpl::present()
 {
     create_info.gl.swapBuffers(create_info.gl.user_data);
+    if(create_info.max_frames_in_flight > 0)
+        pacing.fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
 }
 
 void uvre::RenderDeviceImpl::vsync(bool enable)
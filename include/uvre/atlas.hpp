@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB. All Rights Reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+#include <uvre/renderdevice.hpp>
+#include <vector>
+
+namespace uvre
+{
+struct AtlasCreateInfo final {
+    PixelFormat format;
+    int width;
+    int height;
+    int max_layers;
+    int padding { 0 };
+};
+
+struct AtlasRegion final {
+    int layer;
+    int x, y;
+    int width, height;
+    float u0, v0;
+    float u1, v1;
+};
+
+// Shelf-packs sub-images into the layers of a single
+// texture array so they can be drawn with one binding.
+class UVRE_API TextureAtlas final {
+public:
+    TextureAtlas(IRenderDevice *device, const AtlasCreateInfo &info);
+
+    bool allocate(int width, int height, AtlasRegion &region);
+    void release(const AtlasRegion &region);
+    void clear();
+
+    UploadTicket upload(const AtlasRegion &region, PixelFormat format, const void *data);
+
+    Texture getTexture() const;
+    int getNumLayers() const;
+
+private:
+    struct Span final {
+        int x;
+        int width;
+    };
+
+    struct Shelf final {
+        int y;
+        int height;
+        std::vector<Span> spans;
+    };
+
+    struct Layer final {
+        int top;
+        std::vector<Shelf> shelves;
+    };
+
+    bool allocateInShelf(Shelf &shelf, int width, int &x);
+
+private:
+    IRenderDevice *device;
+    AtlasCreateInfo info;
+    Texture texture;
+    std::vector<Layer> layers;
+};
+} // namespace uvre
@@ -22,8 +22,13 @@ public:
     virtual void setClearColor4f(float r, float g, float b, float a) = 0;
     virtual void clear(RenderTargetMask mask) = 0;
 
+    virtual void beginRenderPass(const RenderPassInfo &info) = 0;
+    virtual void endRenderPass() = 0;
+
     virtual void bindPipeline(Pipeline pipeline) = 0;
-    virtual void bindStorageBuffer(Buffer buffer, uint32_t index) = 0;
+    // Writable buffers are synchronized with later reads automatically,
+    // they count as written by the draws and dispatches whose shaders use them.
+    virtual void bindStorageBuffer(Buffer buffer, uint32_t index, bool writable = false) = 0;
     virtual void bindUniformBuffer(Buffer buffer, uint32_t index) = 0;
     virtual void bindIndexBuffer(Buffer buffer) = 0;
     virtual void bindVertexBuffer(Buffer buffer) = 0;
@@ -31,10 +36,36 @@ public:
     virtual void bindTexture(Texture texture, uint32_t index) = 0;
     virtual void bindRenderTarget(RenderTarget target) = 0;
 
+    // A negative layer binds every layer of an array or cube texture.
+    // Writable images are synchronized with later reads automatically.
+    virtual void bindImage(Texture texture, uint32_t unit, int level, int layer, ImageAccess access, PixelFormat format) = 0;
+
+    // Skipped when the group is already bound to the set
+    virtual void bindGroup(BindGroup group, uint32_t set) = 0;
+
     virtual void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) = 0;
+    virtual void generateMipmaps(Texture texture) = 0;
+
+    // Both textures should have the same format. OpenGL 3.3
+    // drops copies of compressed textures altogether.
+    virtual void copyTexture(Texture src, int src_level, int sx, int sy, int sz, Texture dst, int dst_level, int dx, int dy, int dz, int width, int height, int depth) = 0;
     virtual void copyRenderTarget(RenderTarget src, RenderTarget dst, int sx0, int sy0, int sx1, int sy1, int dx0, int dy0, int dx1, int dy1, RenderTargetMask mask, bool filter) = 0;
 
     virtual void draw(size_t vertices, size_t instances, size_t base_vertex, size_t base_instance) = 0;
     virtual void idraw(size_t indices, size_t instances, size_t base_index, size_t base_vertex, size_t base_instance) = 0;
+
+    // Compute work is not ordered against anything else,
+    // writes have to be made visible with a barrier.
+    virtual void dispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+    virtual void dispatchIndirect(Buffer buffer, size_t offset) = 0;
+    virtual void memoryBarrier(BarrierMask mask) = 0;
+
+    // Timers can be nested, the results show up a few frames later
+    virtual void beginTimer(const char *name) = 0;
+    virtual void endTimer() = 0;
+
+    // Named regions for RenderDoc, apitrace and friends
+    virtual void pushDebugGroup(const char *name) = 0;
+    virtual void popDebugGroup() = 0;
 };
 } // namespace uvre
@@ -38,7 +38,15 @@ enum class BufferType {
 
 enum class ShaderStage {
     VERTEX,
-    FRAGMENT
+    FRAGMENT,
+    GEOMETRY,
+    COMPUTE
+};
+
+enum class ShaderStatus {
+    PENDING,
+    READY,
+    FAILED
 };
 
 enum class ShaderFormat {
@@ -97,6 +105,37 @@ enum class PixelFormat {
     D16_UNORM,
     D32_FLOAT,
     S8_UINT,
+    BC1_UNORM,
+    BC3_UNORM,
+    BC4_UNORM,
+    BC4_SNORM,
+    BC5_UNORM,
+    BC5_SNORM,
+    BC7_UNORM,
+};
+
+enum class BindingType {
+    UNIFORM_BUFFER,
+    STORAGE_BUFFER,
+    SAMPLER,
+    TEXTURE
+};
+
+enum class ImageAccess {
+    READ_ONLY,
+    WRITE_ONLY,
+    READ_WRITE
+};
+
+enum class LoadAction {
+    LOAD,
+    CLEAR,
+    DONT_CARE
+};
+
+enum class StoreAction {
+    STORE,
+    DISCARD
 };
 
 enum class BlendEquation {
@@ -149,6 +188,14 @@ enum class ImplFamily {
     OPENGL
 };
 
+static constexpr const size_t MAX_COLOR_ATTACHMENTS = 8;
+static constexpr const uint32_t MAX_BIND_GROUPS = 4;
+
+// Reserved by the bindless texture table when it's enabled
+static constexpr const uint32_t BINDLESS_TABLE_BINDING = 15;
+static constexpr const uint32_t BINDLESS_PAGE_UNIT = 8;
+static constexpr const uint32_t MAX_BINDLESS_PAGES = 8;
+
 using RenderTargetMask = uint16_t;
 static constexpr const RenderTargetMask RT_COLOR_BUFFER = (1 << 0);
 static constexpr const RenderTargetMask RT_DEPTH_BUFFER = (1 << 1);
@@ -160,6 +207,20 @@ static constexpr const SamplerFlags SAMPLER_CLAMP_T = (1 << 1);
 static constexpr const SamplerFlags SAMPLER_CLAMP_R = (1 << 2);
 static constexpr const SamplerFlags SAMPLER_FILTER = (1 << 3);
 static constexpr const SamplerFlags SAMPLER_FILTER_ANISO = (1 << 4);
+static constexpr const SamplerFlags SAMPLER_MIPMAP = (1 << 5);
+
+using BarrierMask = uint16_t;
+static constexpr const BarrierMask BARRIER_VERTEX_BUFFER = (1 << 0);
+static constexpr const BarrierMask BARRIER_INDEX_BUFFER = (1 << 1);
+static constexpr const BarrierMask BARRIER_UNIFORM_BUFFER = (1 << 2);
+static constexpr const BarrierMask BARRIER_STORAGE_BUFFER = (1 << 3);
+static constexpr const BarrierMask BARRIER_INDIRECT_BUFFER = (1 << 4);
+static constexpr const BarrierMask BARRIER_BUFFER_UPDATE = (1 << 5);
+static constexpr const BarrierMask BARRIER_TEXTURE_FETCH = (1 << 6);
+static constexpr const BarrierMask BARRIER_TEXTURE_UPDATE = (1 << 7);
+static constexpr const BarrierMask BARRIER_IMAGE_ACCESS = (1 << 8);
+static constexpr const BarrierMask BARRIER_RENDER_TARGET = (1 << 9);
+static constexpr const BarrierMask BARRIER_ALL = 0xFFFF;
 
 using CullFlags = uint16_t;
 static constexpr const CullFlags CULL_CLOCKWISE = (1 << 0);
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB. All Rights Reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+#include <uvre/renderdevice.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace uvre
+{
+using FramePass = uint32_t;
+using FrameResource = uint32_t;
+
+// Passes declare what they read and write; the graph orders them,
+// culls the ones nobody depends on and aliases transient targets
+// whose lifetimes don't overlap through the device's target pool.
+class UVRE_API FrameGraph final {
+public:
+    using ExecuteFunc = std::function<void(ICommandList *commands)>;
+
+    FrameGraph(IRenderDevice *device);
+
+    FrameResource createTarget(const TransientTargetCreateInfo &info);
+    FrameResource importTarget(RenderTarget target);
+    FrameResource importTexture(Texture texture);
+    FrameResource importBuffer(Buffer buffer);
+    void markOutput(FrameResource resource);
+
+    FramePass addPass(const char *name, const ExecuteFunc &execute);
+    void read(FramePass pass, FrameResource resource);
+    void write(FramePass pass, FrameResource resource);
+    void markSideEffect(FramePass pass);
+
+    void compile();
+    void execute(ICommandList *commands);
+    void reset();
+
+    RenderTarget getRenderTarget(FrameResource resource) const;
+    Texture getTexture(FrameResource resource, size_t attachment = 0) const;
+    Texture getDepthTexture(FrameResource resource) const;
+    Buffer getBuffer(FrameResource resource) const;
+
+    size_t getNumPasses() const;
+    size_t getNumCulledPasses() const;
+    const char *getPassName(size_t index) const;
+
+private:
+    enum class ResourceType {
+        TRANSIENT_TARGET,
+        IMPORTED_TARGET,
+        IMPORTED_TEXTURE,
+        IMPORTED_BUFFER
+    };
+
+    struct Resource final {
+        ResourceType type;
+        TransientTargetCreateInfo info;
+        std::vector<PixelFormat> color_formats;
+        TransientTarget target;
+        Texture texture;
+        Buffer buffer;
+        bool output;
+        size_t first_use;
+        size_t last_use;
+    };
+
+    struct Pass final {
+        std::string name;
+        ExecuteFunc execute;
+        std::vector<FrameResource> reads;
+        std::vector<FrameResource> writes;
+        bool side_effect;
+        bool alive;
+    };
+
+    bool writes(const Pass &pass, FrameResource resource) const;
+    bool dependsOn(FramePass pass, FramePass other) const;
+
+private:
+    IRenderDevice *device;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<FramePass> order;
+    bool compiled;
+};
+} // namespace uvre
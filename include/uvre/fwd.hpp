@@ -15,6 +15,8 @@ using Buffer = std::shared_ptr<struct Buffer_S>;
 using Sampler = std::shared_ptr<struct Sampler_S>;
 using Texture = std::shared_ptr<struct Texture_S>;
 using RenderTarget = std::shared_ptr<struct RenderTarget_S>;
+using BindGroup = std::shared_ptr<struct BindGroup_S>;
+struct RenderPassInfo;
 class ICommandList;
 class IRenderDevice;
 } // namespace uvre
@@ -19,16 +19,33 @@ struct VertexAttrib final {
     bool normalized;
 };
 
+// A negative layer attaches every layer of an array or
+// cube texture; the shaders then pick one with gl_Layer.
 struct ColorAttachment final {
     uint32_t id;
     Texture color;
+    int level { 0 };
+    int layer { -1 };
 };
 
+// Values are raw 32-bit words, floats have to be bit-cast.
+struct SpecializationConstant final {
+    uint32_t id;
+    uint32_t value;
+};
+
+// Entry points and specialization constants
+// only apply to SPIR-V binaries.
 struct ShaderCreateInfo final {
     ShaderStage stage;
     ShaderFormat format;
     size_t code_size { 0 };
     const void *code;
+    const char *entry_point { nullptr };
+    size_t num_constants { 0 };
+    const SpecializationConstant *constants { nullptr };
+    // Shows up in captures; deduplicated objects keep the first one
+    const char *debug_name { nullptr };
 };
 
 struct PipelineCreateInfo final {
@@ -55,12 +72,15 @@ struct PipelineCreateInfo final {
     const VertexAttrib *vertex_attribs;
     size_t num_shaders;
     Shader *shaders;
+    Pipeline placeholder { nullptr }; // bound while the shaders are still compiling
+    const char *debug_name { nullptr };
 };
 
 struct BufferCreateInfo final {
     BufferType type;
     size_t size;
     const void *data { nullptr };
+    const char *debug_name { nullptr };
 };
 
 struct SamplerCreateInfo final {
@@ -69,6 +89,7 @@ struct SamplerCreateInfo final {
     float min_lod { -1000.0f };
     float max_lod { +1000.0f };
     float lod_bias { 0.0f };
+    const char *debug_name { nullptr };
 };
 
 struct TextureCreateInfo final {
@@ -78,13 +99,74 @@ struct TextureCreateInfo final {
     int height;
     int depth { 0 };
     size_t mip_levels { 0 };
+    const char *debug_name { nullptr };
 };
 
 struct RenderTargetCreateInfo final {
     Texture depth_attachment { nullptr };
     Texture stencil_attachment { nullptr };
+    int depth_level { 0 };
+    int depth_layer { -1 };
+    int stencil_level { 0 };
+    int stencil_layer { -1 };
     size_t num_color_attachments;
     const ColorAttachment *color_attachments;
+    const char *debug_name { nullptr };
+};
+
+// Buffer ranges with a zero size cover the whole buffer
+struct BindGroupEntry final {
+    BindingType type;
+    uint32_t index;
+    Buffer buffer { nullptr };
+    Sampler sampler { nullptr };
+    Texture texture { nullptr };
+    size_t offset { 0 };
+    size_t size { 0 };
+    bool writable { false };
+};
+
+struct BindGroupCreateInfo final {
+    size_t num_entries;
+    const BindGroupEntry *entries;
+};
+
+struct TransientTargetCreateInfo final {
+    int width;
+    int height;
+    size_t num_color_attachments;
+    const PixelFormat *color_formats;
+    bool use_depth { false };
+    PixelFormat depth_format { PixelFormat::D32_FLOAT };
+};
+
+struct TransientTarget final {
+    RenderTarget target;
+    Texture depth;
+    Texture color[MAX_COLOR_ATTACHMENTS];
+};
+
+struct RenderPassColorAttachment final {
+    uint32_t id;
+    LoadAction load;
+    StoreAction store;
+    float clear_color[4];
+};
+
+struct RenderPassInfo final {
+    RenderTarget target { nullptr };
+    size_t num_color_attachments;
+    const RenderPassColorAttachment *color_attachments;
+    struct {
+        LoadAction load;
+        StoreAction store;
+        float clear_value;
+    } depth;
+    struct {
+        LoadAction load;
+        StoreAction store;
+        int clear_value;
+    } stencil;
 };
 
 struct DeviceInfo final {
@@ -93,9 +175,52 @@ struct DeviceInfo final {
     int impl_version_minor;
     bool supports_anisotropic;
     bool supports_storage_buffers;
+    bool supports_compute;
+    bool supports_compression_s3tc;
+    bool supports_compression_rgtc;
+    bool supports_compression_bptc;
+    bool supports_bindless;
     bool supports_shader_format[static_cast<int>(ShaderFormat::NUM_SHADER_FORMATS)];
 };
 
+// Identical create infos yield the same object
+struct CacheStats final {
+    size_t shader_hits;
+    size_t shader_misses;
+    size_t pipeline_hits;
+    size_t pipeline_misses;
+    size_t sampler_hits;
+    size_t sampler_misses;
+};
+
+// Collected between two prepare() calls, everything
+// stays zero when UVRE_FRAME_STATS is turned off.
+struct FrameStats final {
+    size_t num_submits;
+    size_t num_commands;
+    size_t num_binds;
+    struct {
+        size_t storage_buffers;
+        size_t uniform_buffers;
+        size_t index_buffers;
+        size_t vertex_buffers;
+        size_t samplers;
+        size_t textures;
+        size_t images;
+        size_t groups;
+    } binds; // num_binds by kind
+    size_t num_clears;
+    size_t num_copies;
+    size_t num_draws;
+    size_t num_dispatches;
+    size_t num_instances;
+    size_t num_primitives;
+    size_t num_pipeline_switches;
+    size_t num_vao_switches;
+    size_t bytes_written;
+    double submit_time;
+};
+
 struct DebugMessageInfo;
 struct DeviceCreateInfo final {
     struct {
@@ -105,9 +230,26 @@ struct DeviceCreateInfo final {
         void (*setSwapInterval)(void *user_data, int interval);
         void (*swapBuffers)(void *user_data);
     } gl;
+    size_t upload_buffer_size { 16 * 1024 * 1024 };
+    // prepare() blocks while this many frames are still queued up,
+    // one gives the lowest latency and zero doesn't limit anything.
+    int max_frames_in_flight { 2 };
+    bool use_bindless { false };
+    struct {
+        void *user_data;
+        // Copies at most size bytes and returns the stored size, zero if there's nothing
+        size_t (*load)(void *user_data, uint64_t key, void *data, size_t size);
+        void (*store)(void *user_data, uint64_t key, const void *data, size_t size);
+    } program_cache;
     void (*onDebugMessage)(const DebugMessageInfo &msg);
 };
 
+// Names are valid until the next batch of results comes in
+struct TimerResult final {
+    const char *name;
+    double milliseconds;
+};
+
 struct ImplInfo final {
     ImplFamily family;
     struct {
@@ -127,18 +269,54 @@ public:
     virtual ~IRenderDevice() = default;
 
     virtual const DeviceInfo &getInfo() const = 0;
+    virtual const CacheStats &getCacheStats() const = 0;
+
+    // Memory barriers issued so far, the ones that
+    // were inserted automatically by submit included.
+    virtual size_t getNumBarriers() const = 0;
+
+    // Milliseconds the last prepare() spent waiting for the GPU
+    virtual double getFrameWaitTime() const = 0;
+
+    // Statistics of the previous frame
+    virtual const FrameStats &getFrameStats() const = 0;
+
+    // GPU timers of the most recent frame whose queries
+    // are done; that's usually a few frames behind.
+    virtual size_t getNumTimerResults() const = 0;
+    virtual const TimerResult &getTimerResult(size_t index) const = 0;
 
     virtual Shader createShader(const ShaderCreateInfo &info) = 0;
+    virtual Shader createShaderAsync(const ShaderCreateInfo &info) = 0;
+    virtual ShaderStatus getShaderStatus(Shader shader) = 0;
     virtual Pipeline createPipeline(const PipelineCreateInfo &info) = 0;
+    virtual ShaderStatus getPipelineStatus(Pipeline pipeline) = 0;
     virtual Buffer createBuffer(const BufferCreateInfo &info) = 0;
     virtual Sampler createSampler(const SamplerCreateInfo &info) = 0;
     virtual Texture createTexture(const TextureCreateInfo &info) = 0;
     virtual RenderTarget createRenderTarget(const RenderTargetCreateInfo &info) = 0;
+    virtual BindGroup createBindGroup(const BindGroupCreateInfo &info) = 0;
+
+    // Pooled render targets, recycled every frame unless released earlier
+    virtual TransientTarget acquireTransientTarget(const TransientTargetCreateInfo &info) = 0;
+    virtual void releaseTransientTarget(const TransientTarget &target) = 0;
 
     virtual void writeBuffer(Buffer buffer, size_t offset, size_t size, const void *data) = 0;
-    virtual void writeTexture2D(Texture texture, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
-    virtual void writeTextureCube(Texture texture, int face, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
-    virtual void writeTextureArray(Texture texture, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) = 0;
+    virtual void writeTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
+    virtual void writeTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
+    virtual void writeTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) = 0;
+
+    // Staged through a ring buffer, the data can be reused right away
+    virtual UploadTicket uploadTexture2D(Texture texture, int level, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
+    virtual UploadTicket uploadTextureCube(Texture texture, int level, int face, int x, int y, int w, int h, PixelFormat format, const void *data) = 0;
+    virtual UploadTicket uploadTextureArray(Texture texture, int level, int x, int y, int z, int w, int h, int d, PixelFormat format, const void *data) = 0;
+    virtual bool isUploadComplete(UploadTicket ticket) = 0;
+
+    // Shaders sample these with uvre_texture(index, uv). Without
+    // native support textures are copied into shared arrays, so
+    // fill them before making them bindless. Zero means failure.
+    virtual BindlessTexture createBindlessTexture(Texture texture, Sampler sampler) = 0;
+    virtual void destroyBindlessTexture(BindlessTexture index) = 0;
 
     virtual ICommandList *createCommandList() = 0;
     virtual void destroyCommandList(ICommandList *commands) = 0;
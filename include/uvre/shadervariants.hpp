@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB. All Rights Reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+#include <uvre/renderdevice.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uvre
+{
+using ShaderVariantKey = uint64_t;
+
+// Background variants come back pending, pipelines
+// that use them should have a placeholder.
+struct ShaderVariantsCreateInfo final {
+    ShaderStage stage;
+    const char *source;
+    bool background { false };
+};
+
+// Device cache hits don't count as compiles. Background compiles
+// aren't timed, their failures are counted (and returned as null)
+// once getVariant sees them fail.
+struct ShaderVariantStats final {
+    size_t num_requests;
+    size_t num_compiles;
+    size_t num_failures;
+    double compile_time_ms;
+};
+
+// Each axis is a set of mutually exclusive keywords, a variant
+// defines one keyword from every axis. Variants are compiled the
+// first time they're requested and kept around afterwards.
+class UVRE_API ShaderVariantManager final {
+public:
+    ShaderVariantManager(IRenderDevice *device, const ShaderVariantsCreateInfo &info);
+
+    uint32_t addAxis(const char *const *keywords, size_t num_keywords);
+    ShaderVariantKey select(ShaderVariantKey key, uint32_t axis, uint32_t option) const;
+
+    Shader getVariant(ShaderVariantKey key);
+    void clear();
+
+    size_t getNumVariants() const;
+    size_t getNumCompiled() const;
+    const ShaderVariantStats &getStats() const;
+
+private:
+    struct Axis final {
+        std::vector<std::string> keywords;
+        ShaderVariantKey stride;
+    };
+
+    struct Variant final {
+        Shader shader;
+        bool pending;
+    };
+
+private:
+    IRenderDevice *device;
+    ShaderStage stage;
+    std::string source;
+    bool background;
+    std::vector<Axis> axes;
+    ShaderVariantKey num_variants;
+    std::unordered_map<ShaderVariantKey, Variant> variants;
+    ShaderVariantStats stats;
+};
+} // namespace uvre
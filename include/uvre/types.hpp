@@ -13,6 +13,9 @@ namespace uvre
 using std::size_t;
 using std::uint16_t;
 using std::uint32_t;
+using std::uint64_t;
 using Index16 = uint16_t;
 using Index32 = uint32_t;
+using UploadTicket = uint64_t;
+using BindlessTexture = uint32_t;
 } // namespace uvre
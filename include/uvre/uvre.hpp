@@ -5,6 +5,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #pragma once
+#include <uvre/atlas.hpp>
 #include <uvre/commandlist.hpp>
+#include <uvre/framegraph.hpp>
 #include <uvre/renderdevice.hpp>
+#include <uvre/shadervariants.hpp>
 #include <uvre/types.hpp>
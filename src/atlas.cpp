@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB.
+ * All Rights Reserved.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <uvre/atlas.hpp>
+#include <limits>
+
+uvre::TextureAtlas::TextureAtlas(uvre::IRenderDevice *device, const uvre::AtlasCreateInfo &info)
+    : device(device), info(info), texture(nullptr), layers()
+{
+    uvre::TextureCreateInfo texture_info = {};
+    texture_info.type = uvre::TextureType::TEXTURE_ARRAY;
+    texture_info.format = info.format;
+    texture_info.width = info.width;
+    texture_info.height = info.height;
+    texture_info.depth = info.max_layers;
+    texture = device->createTexture(texture_info);
+}
+
+bool uvre::TextureAtlas::allocateInShelf(uvre::TextureAtlas::Shelf &shelf, int width, int &x)
+{
+    for(std::vector<uvre::TextureAtlas::Span>::iterator it = shelf.spans.begin(); it != shelf.spans.end(); it++) {
+        if(it->width < width)
+            continue;
+
+        x = it->x;
+        it->x += width;
+        it->width -= width;
+        if(!it->width)
+            shelf.spans.erase(it);
+        return true;
+    }
+
+    return false;
+}
+
+bool uvre::TextureAtlas::allocate(int width, int height, uvre::AtlasRegion &region)
+{
+    const int padded_width = width + 2 * info.padding;
+    const int padded_height = height + 2 * info.padding;
+
+    if(!texture || width <= 0 || height <= 0 || padded_width > info.width || padded_height > info.height)
+        return false;
+
+    int layer = -1;
+    int x = 0, y = 0;
+
+    // Best fit: look for the shelf that wastes
+    // the least amount of height for this image.
+    uvre::TextureAtlas::Shelf *best_shelf = nullptr;
+    int best_layer = -1;
+    int best_waste = std::numeric_limits<int>::max();
+    for(size_t i = 0; i < layers.size(); i++) {
+        for(uvre::TextureAtlas::Shelf &shelf : layers[i].shelves) {
+            if(shelf.height < padded_height || shelf.height - padded_height >= best_waste)
+                continue;
+            for(const uvre::TextureAtlas::Span &span : shelf.spans) {
+                if(span.width < padded_width)
+                    continue;
+                best_shelf = &shelf;
+                best_layer = static_cast<int>(i);
+                best_waste = shelf.height - padded_height;
+                break;
+            }
+        }
+    }
+
+    if(best_shelf && allocateInShelf(*best_shelf, padded_width, x)) {
+        layer = best_layer;
+        y = best_shelf->y;
+    }
+    else {
+        // Open a new shelf in the first layer that
+        // has enough vertical space left, including
+        // a brand new layer if we're allowed to.
+        for(size_t i = 0; i <= layers.size(); i++) {
+            if(i == layers.size()) {
+                if(static_cast<int>(layers.size()) >= info.max_layers)
+                    return false;
+                layers.push_back(uvre::TextureAtlas::Layer { 0, {} });
+            }
+
+            uvre::TextureAtlas::Layer &candidate = layers[i];
+            if(candidate.top + padded_height > info.height)
+                continue;
+
+            uvre::TextureAtlas::Shelf shelf = {};
+            shelf.y = candidate.top;
+            shelf.height = padded_height;
+            shelf.spans.push_back(uvre::TextureAtlas::Span { padded_width, info.width - padded_width });
+            if(!shelf.spans.back().width)
+                shelf.spans.pop_back();
+            candidate.shelves.push_back(shelf);
+            candidate.top += padded_height;
+
+            layer = static_cast<int>(i);
+            x = 0;
+            y = shelf.y;
+            break;
+        }
+    }
+
+    region.layer = layer;
+    region.x = x + info.padding;
+    region.y = y + info.padding;
+    region.width = width;
+    region.height = height;
+    region.u0 = static_cast<float>(region.x) / static_cast<float>(info.width);
+    region.v0 = static_cast<float>(region.y) / static_cast<float>(info.height);
+    region.u1 = static_cast<float>(region.x + width) / static_cast<float>(info.width);
+    region.v1 = static_cast<float>(region.y + height) / static_cast<float>(info.height);
+    return true;
+}
+
+void uvre::TextureAtlas::release(const uvre::AtlasRegion &region)
+{
+    if(region.layer < 0 || region.layer >= static_cast<int>(layers.size()))
+        return;
+
+    uvre::TextureAtlas::Layer &layer = layers[region.layer];
+    const int x = region.x - info.padding;
+    const int y = region.y - info.padding;
+    const int width = region.width + 2 * info.padding;
+
+    for(uvre::TextureAtlas::Shelf &shelf : layer.shelves) {
+        if(shelf.y != y)
+            continue;
+
+        // Keep the spans sorted and merge the
+        // neighbours so the shelf doesn't fragment.
+        std::vector<uvre::TextureAtlas::Span>::iterator it = shelf.spans.begin();
+        while(it != shelf.spans.end() && it->x < x)
+            it++;
+
+        // Already free, releasing it twice would
+        // let allocate hand the same pixels out again.
+        if(it != shelf.spans.end() && it->x < x + width)
+            return;
+        if(it != shelf.spans.begin() && (it - 1)->x + (it - 1)->width > x)
+            return;
+
+        it = shelf.spans.insert(it, uvre::TextureAtlas::Span { x, width });
+        if(it + 1 != shelf.spans.end() && it->x + it->width == (it + 1)->x) {
+            it->width += (it + 1)->width;
+            shelf.spans.erase(it + 1);
+        }
+        if(it != shelf.spans.begin() && (it - 1)->x + (it - 1)->width == it->x) {
+            (it - 1)->width += it->width;
+            shelf.spans.erase(it);
+        }
+
+        break;
+    }
+
+    // Empty shelves at the top of the layer are given
+    // back so their height can be reused by anything.
+    while(!layer.shelves.empty()) {
+        const uvre::TextureAtlas::Shelf &shelf = layer.shelves.back();
+        if(shelf.spans.size() != 1 || shelf.spans[0].width != info.width)
+            break;
+        layer.top = shelf.y;
+        layer.shelves.pop_back();
+    }
+}
+
+void uvre::TextureAtlas::clear()
+{
+    layers.clear();
+}
+
+uvre::UploadTicket uvre::TextureAtlas::upload(const uvre::AtlasRegion &region, uvre::PixelFormat format, const void *data)
+{
+    if(!texture || region.layer < 0)
+        return 0;
+    return device->uploadTextureArray(texture, 0, region.x, region.y, region.layer, region.width, region.height, 1, format, data);
+}
+
+uvre::Texture uvre::TextureAtlas::getTexture() const
+{
+    return texture;
+}
+
+int uvre::TextureAtlas::getNumLayers() const
+{
+    return static_cast<int>(layers.size());
+}
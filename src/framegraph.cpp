@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB.
+ * All Rights Reserved.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <uvre/commandlist.hpp>
+#include <uvre/framegraph.hpp>
+#include <algorithm>
+#include <limits>
+
+static constexpr const size_t NO_USE = std::numeric_limits<size_t>::max();
+
+uvre::FrameGraph::FrameGraph(uvre::IRenderDevice *device)
+    : device(device), resources(), passes(), order(), compiled(false)
+{
+}
+
+uvre::FrameResource uvre::FrameGraph::createTarget(const uvre::TransientTargetCreateInfo &info)
+{
+    uvre::FrameGraph::Resource resource = {};
+    resource.type = uvre::FrameGraph::ResourceType::TRANSIENT_TARGET;
+    resource.info = info;
+    resource.color_formats.assign(info.color_formats, info.color_formats + info.num_color_attachments);
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<uvre::FrameResource>(resources.size() - 1);
+}
+
+uvre::FrameResource uvre::FrameGraph::importTarget(uvre::RenderTarget target)
+{
+    uvre::FrameGraph::Resource resource = {};
+    resource.type = uvre::FrameGraph::ResourceType::IMPORTED_TARGET;
+    resource.target.target = target;
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<uvre::FrameResource>(resources.size() - 1);
+}
+
+uvre::FrameResource uvre::FrameGraph::importTexture(uvre::Texture texture)
+{
+    uvre::FrameGraph::Resource resource = {};
+    resource.type = uvre::FrameGraph::ResourceType::IMPORTED_TEXTURE;
+    resource.texture = texture;
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<uvre::FrameResource>(resources.size() - 1);
+}
+
+uvre::FrameResource uvre::FrameGraph::importBuffer(uvre::Buffer buffer)
+{
+    uvre::FrameGraph::Resource resource = {};
+    resource.type = uvre::FrameGraph::ResourceType::IMPORTED_BUFFER;
+    resource.buffer = buffer;
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<uvre::FrameResource>(resources.size() - 1);
+}
+
+void uvre::FrameGraph::markOutput(uvre::FrameResource resource)
+{
+    resources[resource].output = true;
+    compiled = false;
+}
+
+uvre::FramePass uvre::FrameGraph::addPass(const char *name, const uvre::FrameGraph::ExecuteFunc &execute)
+{
+    uvre::FrameGraph::Pass pass = {};
+    pass.name = name ? name : "";
+    pass.execute = execute;
+    passes.push_back(pass);
+    compiled = false;
+    return static_cast<uvre::FramePass>(passes.size() - 1);
+}
+
+void uvre::FrameGraph::read(uvre::FramePass pass, uvre::FrameResource resource)
+{
+    passes[pass].reads.push_back(resource);
+    compiled = false;
+}
+
+void uvre::FrameGraph::write(uvre::FramePass pass, uvre::FrameResource resource)
+{
+    passes[pass].writes.push_back(resource);
+    compiled = false;
+}
+
+void uvre::FrameGraph::markSideEffect(uvre::FramePass pass)
+{
+    passes[pass].side_effect = true;
+    compiled = false;
+}
+
+bool uvre::FrameGraph::writes(const uvre::FrameGraph::Pass &pass, uvre::FrameResource resource) const
+{
+    return std::find(pass.writes.cbegin(), pass.writes.cend(), resource) != pass.writes.cend();
+}
+
+bool uvre::FrameGraph::dependsOn(uvre::FramePass pass, uvre::FramePass other) const
+{
+    const uvre::FrameGraph::Pass &a = passes[pass];
+    const uvre::FrameGraph::Pass &b = passes[other];
+
+    // Readers see whatever the writers declared before them left
+    // behind, so reading last frame's history and overwriting it
+    // later in the same graph keeps working.
+    for(uvre::FrameResource resource : a.reads) {
+        if(other < pass && writes(b, resource))
+            return true;
+    }
+
+    // Writers of the same resource keep their declaration order.
+    if(other < pass) {
+        for(uvre::FrameResource resource : a.writes) {
+            if(writes(b, resource))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void uvre::FrameGraph::compile()
+{
+    order.clear();
+
+    // Passes that write something visible outside
+    // of the graph are the roots; everything they
+    // depend on transitively is kept alive as well.
+    std::vector<uvre::FramePass> stack;
+    for(size_t i = 0; i < passes.size(); i++) {
+        uvre::FrameGraph::Pass &pass = passes[i];
+        pass.alive = pass.side_effect;
+        for(uvre::FrameResource resource : pass.writes) {
+            const uvre::FrameGraph::Resource &written = resources[resource];
+            if(written.output || written.type != uvre::FrameGraph::ResourceType::TRANSIENT_TARGET)
+                pass.alive = true;
+        }
+
+        if(pass.alive)
+            stack.push_back(static_cast<uvre::FramePass>(i));
+    }
+
+    while(!stack.empty()) {
+        const uvre::FramePass pass = stack.back();
+        stack.pop_back();
+        for(size_t i = 0; i < passes.size(); i++) {
+            if(passes[i].alive || !dependsOn(pass, static_cast<uvre::FramePass>(i)))
+                continue;
+            passes[i].alive = true;
+            stack.push_back(static_cast<uvre::FramePass>(i));
+        }
+    }
+
+    // Topological sort that prefers the declaration
+    // order whenever more than one pass is ready.
+    std::vector<size_t> num_deps(passes.size(), 0);
+    for(size_t i = 0; i < passes.size(); i++) {
+        for(size_t j = 0; passes[i].alive && j < passes.size(); j++) {
+            if(i != j && passes[j].alive && dependsOn(static_cast<uvre::FramePass>(i), static_cast<uvre::FramePass>(j)))
+                num_deps[i]++;
+        }
+    }
+
+    std::vector<bool> scheduled(passes.size(), false);
+    size_t num_alive = static_cast<size_t>(std::count_if(passes.cbegin(), passes.cend(), [](const uvre::FrameGraph::Pass &pass) { return pass.alive; }));
+    while(order.size() < num_alive) {
+        size_t next = NO_USE;
+        for(size_t i = 0; i < passes.size(); i++) {
+            if(!passes[i].alive || scheduled[i] || num_deps[i])
+                continue;
+            next = i;
+            break;
+        }
+
+        // A cycle: the declaration order breaks it.
+        if(next == NO_USE) {
+            for(size_t i = 0; i < passes.size() && next == NO_USE; i++) {
+                if(passes[i].alive && !scheduled[i])
+                    next = i;
+            }
+        }
+
+        scheduled[next] = true;
+        order.push_back(static_cast<uvre::FramePass>(next));
+        for(size_t i = 0; i < passes.size(); i++) {
+            if(!scheduled[i] && num_deps[i] && passes[i].alive && dependsOn(static_cast<uvre::FramePass>(i), static_cast<uvre::FramePass>(next)))
+                num_deps[i]--;
+        }
+    }
+
+    // Transient targets only live between their first and
+    // last use, so the pool can hand the same memory to
+    // another resource once a target is no longer needed.
+    for(uvre::FrameGraph::Resource &resource : resources) {
+        resource.first_use = NO_USE;
+        resource.last_use = NO_USE;
+    }
+
+    for(size_t i = 0; i < order.size(); i++) {
+        const uvre::FrameGraph::Pass &pass = passes[order[i]];
+        for(const std::vector<uvre::FrameResource> *list : { &pass.reads, &pass.writes }) {
+            for(uvre::FrameResource resource : *list) {
+                if(resources[resource].first_use == NO_USE)
+                    resources[resource].first_use = i;
+                resources[resource].last_use = i;
+            }
+        }
+    }
+
+    compiled = true;
+}
+
+void uvre::FrameGraph::execute(uvre::ICommandList *commands)
+{
+    if(!compiled)
+        compile();
+
+    for(size_t i = 0; i < order.size(); i++) {
+        for(uvre::FrameGraph::Resource &resource : resources) {
+            if(resource.type != uvre::FrameGraph::ResourceType::TRANSIENT_TARGET || resource.first_use != i)
+                continue;
+            resource.info.color_formats = resource.color_formats.data();
+            resource.target = device->acquireTransientTarget(resource.info);
+        }
+
+        // Captures show every pass as its own region
+        const uvre::FrameGraph::Pass &pass = passes[order[i]];
+        commands->pushDebugGroup(pass.name.c_str());
+        if(pass.execute)
+            pass.execute(commands);
+        commands->popDebugGroup();
+
+        // Outputs are read after execute() returns, so they
+        // stay taken until prepare() recycles the pool.
+        for(uvre::FrameGraph::Resource &resource : resources) {
+            if(resource.type != uvre::FrameGraph::ResourceType::TRANSIENT_TARGET || resource.last_use != i || resource.output)
+                continue;
+            device->releaseTransientTarget(resource.target);
+        }
+    }
+}
+
+void uvre::FrameGraph::reset()
+{
+    resources.clear();
+    passes.clear();
+    order.clear();
+    compiled = false;
+}
+
+uvre::RenderTarget uvre::FrameGraph::getRenderTarget(uvre::FrameResource resource) const
+{
+    return resources[resource].target.target;
+}
+
+uvre::Texture uvre::FrameGraph::getTexture(uvre::FrameResource resource, size_t attachment) const
+{
+    if(resources[resource].type == uvre::FrameGraph::ResourceType::IMPORTED_TEXTURE)
+        return resources[resource].texture;
+    if(attachment < uvre::MAX_COLOR_ATTACHMENTS)
+        return resources[resource].target.color[attachment];
+    return nullptr;
+}
+
+uvre::Texture uvre::FrameGraph::getDepthTexture(uvre::FrameResource resource) const
+{
+    return resources[resource].target.depth;
+}
+
+uvre::Buffer uvre::FrameGraph::getBuffer(uvre::FrameResource resource) const
+{
+    return resources[resource].buffer;
+}
+
+size_t uvre::FrameGraph::getNumPasses() const
+{
+    return order.size();
+}
+
+size_t uvre::FrameGraph::getNumCulledPasses() const
+{
+    return passes.size() - order.size();
+}
+
+const char *uvre::FrameGraph::getPassName(size_t index) const
+{
+    return passes[order[index]].name.c_str();
+}
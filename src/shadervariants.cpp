@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2021, Kirill GPRB.
+ * All Rights Reserved.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <uvre/shadervariants.hpp>
+#include <chrono>
+
+uvre::ShaderVariantManager::ShaderVariantManager(uvre::IRenderDevice *device, const uvre::ShaderVariantsCreateInfo &info)
+    : device(device), stage(info.stage), source(info.source ? info.source : ""), background(info.background), axes(), num_variants(1), variants(), stats()
+{
+}
+
+uint32_t uvre::ShaderVariantManager::addAxis(const char *const *keywords, size_t num_keywords)
+{
+    // Keys are mixed-radix numbers with an axis per digit
+    uvre::ShaderVariantManager::Axis axis = {};
+    axis.stride = num_variants;
+    for(size_t i = 0; i < num_keywords; i++)
+        axis.keywords.push_back(keywords[i] ? keywords[i] : "");
+    if(axis.keywords.empty())
+        axis.keywords.push_back("");
+    num_variants *= axis.keywords.size();
+
+    // Existing keys would mean something else now
+    variants.clear();
+
+    axes.push_back(axis);
+    return static_cast<uint32_t>(axes.size() - 1);
+}
+
+uvre::ShaderVariantKey uvre::ShaderVariantManager::select(uvre::ShaderVariantKey key, uint32_t axis, uint32_t option) const
+{
+    if(axis >= axes.size() || option >= axes[axis].keywords.size())
+        return key;
+    const uvre::ShaderVariantKey current = (key / axes[axis].stride) % axes[axis].keywords.size();
+    return key - current * axes[axis].stride + option * axes[axis].stride;
+}
+
+uvre::Shader uvre::ShaderVariantManager::getVariant(uvre::ShaderVariantKey key)
+{
+    stats.num_requests++;
+
+    if(key >= num_variants)
+        return nullptr;
+
+    std::unordered_map<uvre::ShaderVariantKey, uvre::ShaderVariantManager::Variant>::iterator it = variants.find(key);
+    if(it != variants.end()) {
+        // Background compiles get their verdict
+        // the next time someone asks for them.
+        if(it->second.pending) {
+            const uvre::ShaderStatus status = device->getShaderStatus(it->second.shader);
+            if(status != uvre::ShaderStatus::PENDING)
+                it->second.pending = false;
+            if(status == uvre::ShaderStatus::FAILED) {
+                // Same as a failed synchronous compile
+                it->second.shader = nullptr;
+                stats.num_failures++;
+            }
+        }
+
+        return it->second.shader;
+    }
+
+    // Empty keywords stand for "none of these"
+    std::string variant_source;
+    for(const uvre::ShaderVariantManager::Axis &axis : axes) {
+        const std::string &keyword = axis.keywords[(key / axis.stride) % axis.keywords.size()];
+        if(keyword.empty())
+            continue;
+        variant_source += "#define ";
+        variant_source += keyword;
+        variant_source += " 1\n";
+    }
+
+    variant_source += source;
+
+    uvre::ShaderCreateInfo info = {};
+    info.stage = stage;
+    info.format = uvre::ShaderFormat::SOURCE_GLSL;
+    info.code_size = variant_source.size();
+    info.code = variant_source.data();
+
+    const size_t shader_hits = device->getCacheStats().shader_hits;
+    const auto start = std::chrono::steady_clock::now();
+    uvre::Shader shader = background ? device->createShaderAsync(info) : device->createShader(info);
+    const auto end = std::chrono::steady_clock::now();
+
+    // The device might have compiled the same source already. Background
+    // compiles aren't timed, the driver does the actual work elsewhere.
+    if(device->getCacheStats().shader_hits == shader_hits) {
+        stats.num_compiles++;
+        if(!background)
+            stats.compile_time_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Failures are cached as well so that
+    // we don't keep compiling broken code.
+    if(!shader)
+        stats.num_failures++;
+
+    uvre::ShaderVariantManager::Variant &variant = variants[key];
+    variant.shader = shader;
+    variant.pending = background && shader;
+    return shader;
+}
+
+void uvre::ShaderVariantManager::clear()
+{
+    variants.clear();
+}
+
+size_t uvre::ShaderVariantManager::getNumVariants() const
+{
+    return static_cast<size_t>(num_variants);
+}
+
+size_t uvre::ShaderVariantManager::getNumCompiled() const
+{
+    return variants.size();
+}
+
+const uvre::ShaderVariantStats &uvre::ShaderVariantManager::getStats() const
+{
+    return stats;
+}